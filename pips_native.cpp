@@ -0,0 +1,235 @@
+/**
+ * Python extension exposing the C++ solver to the Python tools.
+ * solver.Solver uses it when it can be imported and falls back to the
+ * pure-Python search otherwise.
+ * Build: c++ -std=c++17 -O3 -shared -fPIC $(python3-config --includes) \
+ *            pips_native.cpp -o pips_native$(python3-config --extension-suffix)
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#define PUZZLE_GEN_NO_MAIN
+#include "puzzle_gen.cpp"
+
+// Python object references released on scope exit
+struct PyRef {
+    PyObject* obj;
+    explicit PyRef(PyObject* o) : obj(o) {}
+    ~PyRef() { Py_XDECREF(obj); }
+    PyRef(const PyRef&) = delete;
+    PyRef& operator=(const PyRef&) = delete;
+    operator PyObject*() const { return obj; }
+};
+
+// Integer attribute; none_value stands in for None. False with a Python
+// error set if the attribute is missing or not an int.
+static bool int_attr(PyObject* obj, const char* name, int& out, int none_value = INT_MIN) {
+    PyRef value(PyObject_GetAttrString(obj, name));
+    if (!value) return false;
+    if (value.obj == Py_None && none_value != INT_MIN) {
+        out = none_value;
+        return true;
+    }
+    long v = PyLong_AsLong(value);
+    if (v == -1 && PyErr_Occurred()) return false;
+    out = (int)v;
+    return true;
+}
+
+// Dominoes from a list of domino_sets.Domino, or a DominoSet
+static bool read_dominoes(PyObject* supply, vector<Domino>& dominoes) {
+    PyRef list(PyObject_HasAttrString(supply, "dominoes") ? PyObject_GetAttrString(supply, "dominoes")
+                                                          : (Py_INCREF(supply), supply));
+    PyRef seq(PySequence_Fast(list, "dominoes must be a sequence"));
+    if (!seq) return false;
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(seq.obj);
+    if (n > 64) {
+        PyErr_SetString(PyExc_ValueError, "at most 64 dominoes are supported");
+        return false;
+    }
+    for (Py_ssize_t i = 0; i < n; i++) {
+        PyObject* item = PySequence_Fast_GET_ITEM(seq.obj, i);
+        int low, high;
+        if (!int_attr(item, "low", low) || !int_attr(item, "high", high)) return false;
+        if (low < 0 || high < 0 || low > 15 || high > 15) {
+            PyErr_SetString(PyExc_ValueError, "domino pips must be between 0 and 15");
+            return false;
+        }
+        dominoes.push_back({min(low, high), max(low, high)});
+    }
+    return true;
+}
+
+// Regions from a list of grid.Region
+static bool read_regions(PyObject* list, int rows, int cols, vector<Region>& regions) {
+    PyRef seq(PySequence_Fast(list, "regions must be a sequence"));
+    if (!seq) return false;
+    for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(seq.obj); i++) {
+        PyObject* item = PySequence_Fast_GET_ITEM(seq.obj, i);
+        Region region{};
+        if (!int_attr(item, "id", region.id) ||
+            !int_attr(item, "target_value", region.target_value, -1) ||
+            !int_attr(item, "linked_region_id", region.linked_region_id, -1)) return false;
+        if (region.id < 0) {
+            PyErr_SetString(PyExc_ValueError, "region ids must not be negative");
+            return false;
+        }
+
+        // ConstraintType is an Enum whose values are the lowercase names
+        PyRef type(PyObject_GetAttrString(item, "constraint_type"));
+        PyRef value(type ? PyObject_GetAttrString(type, "value") : nullptr);
+        const char* name = value ? PyUnicode_AsUTF8(value) : nullptr;
+        if (!name) return false;
+        string_view t = name;
+        if (t == "sum") region.type = ConstraintType::SUM;
+        else if (t == "equal") region.type = ConstraintType::EQUAL;
+        else if (t == "unequal") region.type = ConstraintType::UNEQUAL;
+        else if (t == "less") region.type = ConstraintType::LESS;
+        else if (t == "greater") region.type = ConstraintType::GREATER;
+        else if (t == "empty") region.type = ConstraintType::EMPTY;
+        else {
+            PyErr_Format(PyExc_ValueError, "unknown constraint type '%s'", name);
+            return false;
+        }
+
+        PyRef cells(PyObject_GetAttrString(item, "cells"));
+        PyRef cell_seq(cells ? PySequence_Fast(cells, "cells must be a sequence") : nullptr);
+        if (!cell_seq) return false;
+        for (Py_ssize_t j = 0; j < PySequence_Fast_GET_SIZE(cell_seq.obj); j++) {
+            int r, c;
+            if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(cell_seq.obj, j), "ii", &r, &c)) return false;
+            if (r < 0 || r >= rows || c < 0 || c >= cols) {
+                PyErr_Format(PyExc_ValueError, "cell (%d, %d) is outside the %dx%d grid", r, c, rows, cols);
+                return false;
+            }
+            region.cells.push_back({r, c});
+        }
+        if (region.cells.empty()) {
+            PyErr_Format(PyExc_ValueError, "region %d has no cells", region.id);
+            return false;
+        }
+        regions.push_back(move(region));
+    }
+    for (const auto& region : regions) {
+        bool linked = (region.type == ConstraintType::LESS || region.type == ConstraintType::GREATER) &&
+                      region.linked_region_id >= 0;
+        if (linked && none_of(regions.begin(), regions.end(),
+                              [&](const Region& r) { return r.id == region.linked_region_id; })) {
+            PyErr_Format(PyExc_ValueError, "region %d links to missing region %d",
+                         region.id, region.linked_region_id);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool read_engine(const char* name, Engine& engine) {
+    string_view e = name ? name : "auto";
+    if (e == "auto") engine = Engine::AUTO;
+    else if (e == "tilings") engine = Engine::TILINGS;
+    else if (e == "dlx") engine = Engine::DLX;
+    else if (e == "backtrack") engine = Engine::BACKTRACK;
+    else if (e == "sat") engine = Engine::SAT;
+    else {
+        PyErr_Format(PyExc_ValueError, "unknown engine '%s'", name);
+        return false;
+    }
+    return true;
+}
+
+// Solve with the GIL released and return (count, first solution), the
+// solution as (low, high, row, col, horizontal) tuples in placement order
+// with low/high as laid out from the top-left cell, or None if unsolved
+static PyObject* solve_and_wrap(const vector<Domino>& dominoes, const vector<Region>& regions,
+                                int rows, int cols, int max_solutions, Engine engine) {
+    if (rows <= 0 || cols <= 0 || rows * cols > MAX_CELLS) {
+        PyErr_Format(PyExc_ValueError, "grids are limited to %d cells", MAX_CELLS);
+        return nullptr;
+    }
+    if (max_solutions < 1) {
+        PyErr_SetString(PyExc_ValueError, "max_solutions must be at least 1");
+        return nullptr;
+    }
+
+    int count;
+    vector<PlacedDomino> solution;
+    Py_BEGIN_ALLOW_THREADS
+    Solver solver(dominoes, regions, rows, cols, max_solutions);
+    count = min(solve_with(solver, engine), max_solutions);
+    solution = move(solver.first_solution);
+    Py_END_ALLOW_THREADS
+
+    if (count == 0) return Py_BuildValue("(iO)", 0, Py_None);
+    PyRef placements(PyList_New(solution.size()));
+    if (!placements) return nullptr;
+    for (size_t i = 0; i < solution.size(); i++) {
+        const PlacedDomino& p = solution[i];
+        PyObject* item = Py_BuildValue("(iiiiO)", p.pip1(), p.pip2(), p.row, p.col,
+                                       p.horizontal ? Py_True : Py_False);
+        if (!item) return nullptr;
+        PyList_SET_ITEM(placements.obj, i, item);
+    }
+    return Py_BuildValue("(iO)", count, placements.obj);
+}
+
+static PyObject* native_solve(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"puzzle", "max_solutions", "engine", nullptr};
+    PyObject* puzzle;
+    int max_solutions = 2;
+    const char* engine_name = nullptr;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|iz", (char**)keywords,
+                                     &puzzle, &max_solutions, &engine_name)) return nullptr;
+
+    Engine engine;
+    int rows, cols;
+    vector<Domino> dominoes;
+    vector<Region> regions;
+    if (!read_engine(engine_name, engine) ||
+        !int_attr(puzzle, "rows", rows) || !int_attr(puzzle, "cols", cols)) return nullptr;
+    PyRef supply(PyObject_GetAttrString(puzzle, "supply"));
+    PyRef region_list(supply ? PyObject_GetAttrString(puzzle, "regions") : nullptr);
+    if (!region_list || !read_dominoes(supply, dominoes) ||
+        !read_regions(region_list, rows, cols, regions)) return nullptr;
+    return solve_and_wrap(dominoes, regions, rows, cols, max_solutions, engine);
+}
+
+static PyObject* native_test_puzzle(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"dominoes", "rows", "cols", "regions", "max_solutions", "engine",
+                                     nullptr};
+    PyObject *supply, *region_list;
+    int rows, cols, max_solutions = 2;
+    const char* engine_name = nullptr;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OiiO|iz", (char**)keywords, &supply, &rows,
+                                     &cols, &region_list, &max_solutions, &engine_name)) return nullptr;
+
+    Engine engine;
+    vector<Domino> dominoes;
+    vector<Region> regions;
+    if (!read_engine(engine_name, engine) || !read_dominoes(supply, dominoes) ||
+        !read_regions(region_list, rows, cols, regions)) return nullptr;
+    return solve_and_wrap(dominoes, regions, rows, cols, max_solutions, engine);
+}
+
+static PyMethodDef native_methods[] = {
+    {"solve", (PyCFunction)(void (*)(void))native_solve, METH_VARARGS | METH_KEYWORDS,
+     "solve(puzzle, max_solutions=2, engine='auto') -> (count, solution)\n\n"
+     "Count the distinct solutions of a grid.Puzzle, stopping at max_solutions.\n"
+     "solution is the first one found as (low, high, row, col, horizontal)\n"
+     "tuples, or None when there is none. engine is auto, tilings, dlx,\n"
+     "backtrack or sat; auto takes sat on large boards and tilings otherwise."},
+    {"test_puzzle", (PyCFunction)(void (*)(void))native_test_puzzle, METH_VARARGS | METH_KEYWORDS,
+     "test_puzzle(dominoes, rows, cols, regions, max_solutions=2, engine='auto')\n"
+     "    -> (count, solution)\n\n"
+     "Like solve(), from a list of Domino (or a DominoSet) and grid.Region objects."},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+static PyModuleDef native_module = {
+    PyModuleDef_HEAD_INIT, "pips_native", "C++ solver for domino placement puzzles.", -1,
+    native_methods, nullptr, nullptr, nullptr, nullptr
+};
+
+PyMODINIT_FUNC PyInit_pips_native() {
+    return PyModule_Create(&native_module);
+}
@@ -7,15 +7,29 @@
 #include <iostream>
 #include <vector>
 #include <array>
-#include <set>
 #include <map>
+#include <unordered_set>
 #include <algorithm>
+#include <numeric>
 #include <thread>
+#include <deque>
+#include <list>
+#include <functional>
+#include <condition_variable>
 #include <mutex>
 #include <atomic>
+#include <bitset>
 #include <chrono>
 #include <optional>
 #include <sstream>
+#include <fstream>
+#include <string_view>
+#include <memory>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -36,45 +50,428 @@ struct Domino {
 // Cell position
 using Cell = pair<int, int>;
 
-// Constraint types
-enum class ConstraintType { SUM, EQUAL, LESS, GREATER };
+// Constraint types. LESS/GREATER compare the region's sum with the linked
+// region's sum, or with target_value when no region is linked.
+enum class ConstraintType { SUM, EQUAL, LESS, GREATER, UNEQUAL, EMPTY };
 
 // Region definition
 struct Region {
     int id;
     vector<Cell> cells;
     ConstraintType type;
-    int target_value = -1;       // For SUM
-    int linked_region_id = -1;   // For LESS/GREATER
+    int target_value = -1;       // For SUM and threshold LESS/GREATER; OPEN_TARGET
+                                 // leaves a SUM unconstrained
+    int linked_region_id = -1;   // For LESS/GREATER, -1 for a threshold
 };
 
+// SUM target left open by sweep_targets()
+constexpr int OPEN_TARGET = -1;
+
 // Placed domino
 struct PlacedDomino {
     Domino domino;
     int row, col;
     bool horizontal;
+    bool flipped = false;    // High pip on cell1
 
     Cell cell1() const { return {row, col}; }
+    int pip1() const { return flipped ? domino.high : domino.low; }
+    int pip2() const { return flipped ? domino.low : domino.high; }
     Cell cell2() const {
         return horizontal ? Cell{row, col + 1} : Cell{row + 1, col};
     }
 };
 
-// Solver state
+// Cell bitboard: bit (row * cols + col) is set for each cell in the mask.
+// Boards up to MAX_CELLS cells are supported.
+using CellMask = unsigned __int128;
+constexpr int MAX_CELLS = 128;
+
+inline CellMask cell_bit(int idx) { return (CellMask)1 << idx; }
+
+// Running aggregates for one region, kept in step with place()/unplace()
+struct RegionTally {
+    int sum = 0;
+    int filled = 0;
+    int equal_ref = -1;   // Pip of the first filled cell, -1 while empty
+    int mismatches = 0;   // Filled cells whose pip differs from equal_ref
+    uint16_t seen_pips = 0;  // Bit p set => some filled cell holds pip p
+    int repeats = 0;      // Filled cells whose pip was already in seen_pips
+};
+
+// Rejected placements are attributed to the constraint type whose check
+// failed, or to the symmetry-breaking order
+constexpr int NUM_CONSTRAINT_TYPES = 6;
+constexpr int PRUNED_BY_SYMMETRY = NUM_CONSTRAINT_TYPES;
+const char* const PRUNE_REASONS[] = {"sum", "equal", "less", "greater", "unequal", "empty",
+                                     "symmetry"};
+
+// Search-tree counters of one solve
+struct SearchStats {
+    uint64_t nodes = 0;        // Dominoes placed
+    uint64_t dead_ends = 0;    // Cells, slots or columns no placement survived on
+    array<uint64_t, NUM_CONSTRAINT_TYPES + 1> pruned{};  // Only counted with telemetry on
+    uint64_t tt_probes = 0;    // Transposition table lookups
+    uint64_t tt_hits = 0;      // Lookups that settled a subproblem without searching it
+
+    void add(const SearchStats& s) {
+        nodes += s.nodes;
+        dead_ends += s.dead_ends;
+        tt_probes += s.tt_probes;
+        tt_hits += s.tt_hits;
+        for (size_t i = 0; i < pruned.size(); i++) pruned[i] += s.pruned[i];
+    }
+};
+
+// Distinct fillings found under one search node, capped at 2; for the
+// first, the Zobrist hash of its pips and whether it has a distinct mirror
+struct Completions {
+    int count = 0;
+    uint64_t hash = 0;
+    bool mirrored = false;
+};
+
+// Solver state, mutated in place by place()/unplace()
 struct SolverState {
-    vector<PlacedDomino> placed;
-    set<Domino> used_dominoes;
-    set<Cell> filled_cells;
-    map<Cell, int> cell_values;
+    vector<PlacedDomino> placed;             // Used as a stack
+    uint64_t used_dominoes = 0;              // Bit i set => dominoes[i] placed (max 64)
+    CellMask filled_cells = 0;
+    array<uint8_t, MAX_CELLS> cell_values{}; // Pip per dense cell index
+    CellMask repeated_cells = 0;             // Cells counted in a tally's repeats
+    vector<RegionTally> region_tally;        // Per region index
+    array<uint8_t, 16> supply{};             // Pips on the dominoes not yet placed, by value
+    uint16_t supply_mask = 0;                // Bit p set => supply[p] > 0
+    array<uint8_t, 256> pair_count{};        // Unused dominoes by low * 16 + high
+    array<uint16_t, 16> partners{};          // Bit q of [p] set => an unused p-q domino
+    uint64_t pip_hash = 0;                   // Zobrist hash of the filled cells' pips
+    uint64_t fill_hash = 0;                  // Of which cells are filled and dominoes used
+    Completions completions;                 // Of the innermost node keeping a tally
+    SearchStats stats;
+    int task_rank = 0;                       // Frontier node a parallel solve's task started from
+};
+
+// Work-stealing thread pool. Each worker owns a deque of tasks: it pops
+// its own work newest-first and, when empty, steals the oldest task from
+// another worker, so uneven chunks balance out across cores.
+class ThreadPool {
+public:
+    using Task = function<void(int)>;  // Called with the worker id
+
+    explicit ThreadPool(int n_threads) : queues(n_threads), busy(n_threads) {
+        for (int i = 0; i < n_threads; i++) {
+            workers.emplace_back(&ThreadPool::worker_loop, this, i);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> lock(state_mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : workers) t.join();
+    }
+
+    int size() const { return workers.size(); }
+
+    // Time worker has spent running tasks, including the one in progress
+    double busy_seconds(int worker) const {
+        uint64_t ns = busy[worker].ns.load(memory_order_relaxed);
+        uint64_t since = busy[worker].since.load(memory_order_relaxed);
+        if (since) ns += clock_ns() - since;
+        return ns * 1e-9;
+    }
+
+    void submit(Task task) {
+        size_t target = next_queue++ % queues.size();
+        {
+            lock_guard<mutex> lock(queues[target].m);
+            queues[target].tasks.push_back(move(task));
+        }
+        {
+            lock_guard<mutex> lock(state_mutex);
+            pending++;
+        }
+        wake.notify_one();
+    }
+
+    // Queue all of tasks before any of them can start, so workers see
+    // them in the order given rather than whichever arrived first
+    void submit_all(vector<Task>& tasks) {
+        for (auto& task : tasks) {
+            size_t target = next_queue++ % queues.size();
+            lock_guard<mutex> lock(queues[target].m);
+            queues[target].tasks.push_back(move(task));
+        }
+        {
+            lock_guard<mutex> lock(state_mutex);
+            pending += tasks.size();
+        }
+        wake.notify_all();
+        tasks.clear();
+    }
+
+private:
+    struct WorkQueue {
+        mutex m;
+        deque<Task> tasks;
+    };
+
+    struct alignas(64) BusyTime {
+        atomic<uint64_t> ns{0};       // Finished tasks
+        atomic<uint64_t> since{0};    // Start of the running task, 0 when idle
+    };
+
+    static uint64_t clock_ns() {
+        return chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    vector<WorkQueue> queues;
+    vector<BusyTime> busy;     // Per worker
+    vector<thread> workers;
+    atomic<size_t> next_queue{0};
+
+    mutex state_mutex;
+    condition_variable wake;
+    size_t pending = 0;      // Queued tasks not yet taken by a worker
+    bool stopping = false;
+
+    bool take(int self, Task& out) {
+        {
+            WorkQueue& own = queues[self];
+            lock_guard<mutex> lock(own.m);
+            if (!own.tasks.empty()) {
+                out = move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (size_t k = 1; k < queues.size(); k++) {
+            WorkQueue& victim = queues[(self + k) % queues.size()];
+            lock_guard<mutex> lock(victim.m);
+            if (!victim.tasks.empty()) {
+                out = move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void worker_loop(int self) {
+        while (true) {
+            {
+                unique_lock<mutex> lock(state_mutex);
+                wake.wait(lock, [this] { return pending > 0 || stopping; });
+                if (pending == 0 && stopping) return;
+                pending--;
+            }
+            // Tasks are pushed before pending is bumped, so a reservation
+            // always has a queued task to find somewhere.
+            Task task;
+            while (!take(self, task)) this_thread::yield();
+            uint64_t t0 = clock_ns();
+            busy[self].since.store(t0, memory_order_relaxed);
+            task(self);
+            busy[self].since.store(0, memory_order_relaxed);
+            busy[self].ns.fetch_add(clock_ns() - t0, memory_order_relaxed);
+        }
+    }
+};
+
+// Tracks completion of a batch of pool tasks
+class TaskGroup {
+public:
+    void add(int n = 1) {
+        lock_guard<mutex> lock(m);
+        outstanding += n;
+    }
+    void done() {
+        lock_guard<mutex> lock(m);
+        if (--outstanding == 0) cv.notify_all();
+    }
+    void wait() {
+        unique_lock<mutex> lock(m);
+        cv.wait(lock, [this] { return outstanding == 0; });
+    }
+
+private:
+    mutex m;
+    condition_variable cv;
+    int outstanding = 0;
+};
+
+// Fillings found by the tasks of one parallel solve, told apart by their
+// pips as record_solution() does. count is also read without the lock,
+// so that every task stops once enough fillings are in.
+struct SharedSolutions {
+    mutex m;
+    atomic<int> count{0};
+    int first_rank = INT_MAX;                 // Frontier node the first filling's placements are from
+    array<uint8_t, MAX_CELLS> first_pips{};
+    vector<PlacedDomino> first_solution;
+    unordered_set<uint64_t> seen_hashes;      // Only used when max_solutions > 2
+    SearchStats stats;                        // Of the finished tasks
+};
+
+// Fillings found for one tuple of open SUM targets
+struct SweepEntry {
+    vector<int> targets;                      // Sums of the open regions, in region order
+    int count = 0;                            // Distinct fillings, capped at 2
+    array<uint8_t, MAX_CELLS> signature{};    // Pips of the first filling
+    vector<PlacedDomino> solution;            // Placements of the first filling
+};
+
+// 64-bit counter split into cache-line sized shards so threads bumping
+// it on every attempt don't fight over one line. Each thread sticks to
+// the shard it was handed on first use; load() sums them on demand.
+class ShardedCounter {
+public:
+    void operator++(int) { add(1); }
+
+    void add(uint64_t n) {
+        shards[shard_index()].value.fetch_add(n, memory_order_relaxed);
+    }
+
+    uint64_t load() const {
+        uint64_t total = 0;
+        for (const auto& s : shards) total += s.value.load(memory_order_relaxed);
+        return total;
+    }
+
+    // Only while no thread is counting, e.g. when restoring a checkpoint
+    void store(uint64_t v) {
+        for (auto& s : shards) s.value.store(0, memory_order_relaxed);
+        shards[0].value.store(v, memory_order_relaxed);
+    }
+
+private:
+    static constexpr int SHARDS = 64;
+    struct alignas(64) Shard {
+        atomic<uint64_t> value{0};
+    };
+    array<Shard, SHARDS> shards;
+
+    static int shard_index() {
+        static atomic<int> next_thread{0};
+        thread_local int index = next_thread.fetch_add(1) % SHARDS;
+        return index;
+    }
+};
+
+// This host's part of a --shard K/N run: shard K of N takes ranks
+// [n*K/N, n*(K+1)/N) of every search over [0, n), so the N hosts cover
+// each search exactly once between them
+struct ShardRange {
+    uint64_t index = 0, count = 1;
+    bool enabled = false;
+
+    uint64_t begin(uint64_t n) const { return (unsigned __int128)n * index / count; }
+    uint64_t end(uint64_t n) const { return (unsigned __int128)n * (index + 1) / count; }
+};
+
+ShardRange shard;
+
+// Result state of one search. The unique puzzle at the lowest rank wins,
+// so the answer depends neither on thread timing and task order nor on how
+// a sharded run split the ranks: rank is the best so far, and workers drop
+// the ranks above it while those below are still searched. set stops the
+// search outright, e.g. once daily mode has all the candidates it wants.
+struct Found {
+    atomic<bool> set{false};
+    atomic<uint64_t> rank{UINT64_MAX};
+
+    // Whether a worker about to try this rank can stop
+    bool done(uint64_t at) const { return set.load() || at > rank.load(); }
+};
+
+// Global for thread coordination. A search's result slot belongs to the
+// thread whose claim() succeeds. Claims are made under console_mutex,
+// which keeps concurrent messages whole and, in a sharded run, stops a
+// slower worker overwriting a better result.
+mutex console_mutex;
+Found found_easy1;
+Found found_easy2;
+Found found_medium;
+Found found_hard;
+ShardedCounter found_random;
+ShardedCounter refine_solves;                 // Solves refine mode spent, unique or not
+constexpr int REFINE_STEPS = 16;              // Refinements refine mode tries per sample
+ShardedCounter total_attempts;
+
+// Claim a search's result slot for the puzzle at rank; true whenever rank
+// beats the best so far
+bool claim(Found& found, uint64_t rank) {
+    uint64_t best = found.rank.load();
+    while (rank < best && !found.rank.compare_exchange_weak(best, rank)) {}
+    return rank < best;
+}
+
+// Attempts the feasibility pre-filter rejected, indexed by Rejection
+enum class Rejection { NONE, SUM_RANGE, PIP_MULTISET, ORDERING, TOTAL };
+constexpr int NUM_REJECTIONS = 5;
+array<ShardedCounter, NUM_REJECTIONS> rejections;
+
+// Run-wide search telemetry, fed by solve_with() and parallel_for() and
+// read by the progress reporter. Only attributing pruned placements costs
+// anything (it re-runs the failing check), so solvers do that just when
+// enabled; the rest are plain increments on each solve's own state.
+class Telemetry {
+public:
+    bool enabled = false;
+    ShardedCounter nodes, dead_ends;
+    array<ShardedCounter, NUM_CONSTRAINT_TYPES + 1> pruned;
+    ShardedCounter tt_probes, tt_hits;
+
+    // Ranks of one parallel_for done so far, for the ETA
+    struct Phase {
+        string name;
+        uint64_t total;
+        uint64_t start_done;   // Already done when it began, e.g. on resume
+        atomic<uint64_t> done;
+        chrono::steady_clock::time_point start;
+    };
+
+    void add(const SearchStats& s) {
+        nodes.add(s.nodes);
+        if (s.dead_ends) dead_ends.add(s.dead_ends);
+        if (s.tt_probes) tt_probes.add(s.tt_probes);
+        if (s.tt_hits) tt_hits.add(s.tt_hits);
+        for (size_t i = 0; i < s.pruned.size(); i++) {
+            if (s.pruned[i]) pruned[i].add(s.pruned[i]);
+        }
+    }
+
+    Phase* begin_phase(const string& name, uint64_t total, uint64_t done) {
+        lock_guard<mutex> lock(m);
+        Phase& phase = phases.emplace_back();
+        phase.name = name;
+        phase.total = total;
+        phase.start_done = done;
+        phase.done = done;
+        phase.start = chrono::steady_clock::now();
+        return &phase;
+    }
+
+    void end_phase(Phase* phase) {
+        lock_guard<mutex> lock(m);
+        phases.remove_if([phase](const Phase& p) { return &p == phase; });
+    }
+
+    // Calls f on each phase in flight while holding the lock
+    template <class F>
+    void for_each_phase(F f) {
+        lock_guard<mutex> lock(m);
+        for (const auto& phase : phases) f(phase);
+    }
+
+private:
+    mutex m;
+    list<Phase> phases;   // Stable addresses for the running loops
 };
 
-// Global for thread coordination
-mutex result_mutex;
-atomic<bool> found_easy1{false};
-atomic<bool> found_easy2{false};
-atomic<bool> found_medium{false};
-atomic<bool> found_hard{false};
-atomic<int> total_attempts{0};
+Telemetry telemetry;
 
 // Result storage
 struct PuzzleResult {
@@ -89,744 +486,5232 @@ optional<PuzzleResult> easy1_result;
 optional<PuzzleResult> easy2_result;
 optional<PuzzleResult> medium_result;
 optional<PuzzleResult> hard_result;
+optional<PuzzleResult> random_result;         // From the lowest unique sample
+
+// Lowest unique random sample per worker, merged once sampling ends
+struct alignas(64) RandomSlot {
+    uint64_t sample = UINT64_MAX;
+    optional<PuzzleResult> result;
+};
+vector<RandomSlot> random_slots;
+atomic<uint64_t> random_best_sample{UINT64_MAX};  // Only decides what to announce
 
 // Forward declarations
 void print_result(const string& name, const optional<PuzzleResult>& result);
 
-// Solver class
-class Solver {
+// Neighbors of each cell of a full Rows x Cols grid, in the order of
+// Solver::adjacent (up, down, left, right), -1 terminated
+template <int Rows, int Cols>
+constexpr array<array<int, 4>, Rows * Cols> grid_neighbors() {
+    array<array<int, 4>, Rows * Cols> table{};
+    for (int idx = 0; idx < Rows * Cols; idx++) {
+        int row = idx / Cols, col = idx % Cols, n = 0;
+        table[idx] = {-1, -1, -1, -1};
+        if (row > 0) table[idx][n++] = idx - Cols;
+        if (row < Rows - 1) table[idx][n++] = idx + Cols;
+        if (col > 0) table[idx][n++] = idx - 1;
+        if (col < Cols - 1) table[idx][n++] = idx + 1;
+    }
+    return table;
+}
+
+// Board size and pip bound fixed at compile time. The search loops are
+// instantiated per shape, so those of the common layouts run with
+// constant cell counts and strides, a constant neighbor table and pip
+// loops of known length. Rows == 0 takes the board from the Solver's
+// tables at run time, MaxPip == 0 its max_pip.
+template <int Rows, int Cols, int MaxPip>
+struct Shape {
+    static constexpr bool fixed_board = Rows > 0;
+    static constexpr int rows = Rows, cols = Cols, cells = Rows * Cols, max_pip = MaxPip;
+    static constexpr array<array<int, 4>, Rows * Cols> neighbors = grid_neighbors<Rows, Cols>();
+};
+using GenericShape = Shape<0, 0, 0>;
+
+// Zobrist key of one search feature, such as a pip on a cell: a fixed
+// pseudo-random value (the splitmix64 finalizer of the feature), so a
+// state's hash is the XOR of its features' keys and is kept up to date
+// one feature at a time
+inline uint64_t zobrist(uint64_t feature) {
+    uint64_t z = feature * 0x9e3779b97f4a7c15ull + 0x632be59bd9b4e019ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// Feature kinds, in the top byte of a feature
+enum : uint64_t { Z_PIP = 1ull << 56, Z_CELL = 2ull << 56, Z_DOMINO = 3ull << 56,
+                  Z_REGION = 4ull << 56, Z_PUZZLE = 5ull << 56 };
+
+// Completions of backtracking subproblems already searched. A subproblem
+// is keyed by everything its completions depend on: the puzzle, the
+// filled cells, the dominoes used, the region tallies the constraints
+// read and the pips on the symmetry-breaking cells. Different placement
+// orders reaching the same key have the same completions, so a repeat is
+// settled from the entry rather than searched again. The table is a fixed
+// array of slots, overwritten freely, with one per thread so it needs no
+// locks; it outlives each solve, so repeated solves of a puzzle on a
+// thread reuse each other's entries.
+class TranspositionTable {
 public:
-    vector<Domino> dominoes;
-    vector<Region> regions;
-    int rows, cols;
-    int max_solutions;
+    struct Entry {
+        uint64_t key = 0;          // 0 while unused; real keys are odd
+        uint64_t completion = 0;   // Zobrist pip hash of the one completion
+        uint8_t count = 0;         // Distinct completions, capped at 2
+        bool mirrored = false;     // The one completion has a distinct mirror
+    };
+
+    const Entry* probe(uint64_t key) const {
+        const Entry& e = slots[key >> (64 - SIZE_BITS)];
+        return e.key == key ? &e : nullptr;
+    }
 
-    map<Cell, int> cell_to_region;
-    map<int, Region*> region_by_id;
-    set<Cell> all_cells;
+    void store(uint64_t key, const Completions& c, uint64_t completion) {
+        slots[key >> (64 - SIZE_BITS)] = {key, completion, (uint8_t)c.count, c.mirrored};
+    }
 
-    vector<SolverState> solutions;
-    set<map<Cell, int>> seen_signatures;
+private:
+    static constexpr int SIZE_BITS = 15;
+    vector<Entry> slots = vector<Entry>(1 << SIZE_BITS);
+};
 
-    Solver(const vector<Domino>& doms, const vector<Region>& regs, int r, int c, int max_sol = 2)
-        : dominoes(doms), regions(regs), rows(r), cols(c), max_solutions(max_sol) {
+thread_local TranspositionTable transpositions;
+
+// Board tables of a puzzle layout: its cells, regions and links, without
+// the dominoes. Cells are dense indices row * cols + col. Built once per
+// search function and loaded into a thread's Solver per attempt, so the
+// tables are not rebuilt for every domino set and target. Symmetries are
+// the board involutions mapping regions onto regions of the same type and
+// links; each solve keeps the first whose targets also match.
+struct CompiledLayout {
+    struct Symmetry {
+        vector<int> cell_map;                 // Dense cell index -> image
+        vector<int> region_map;               // Region index -> image region
+        int cell, image;                      // First cell the map moves
+    };
+
+    uint64_t id;                              // Unique per layout built
+    int rows, cols;
+    vector<Region> regions;                   // Targets are per attempt
+    int num_cells = 0;
+    CellMask board_mask = 0;
+    vector<int> cell_to_region;               // Region index, -1 if off-board
+    vector<array<int, 4>> adjacent;           // Neighbor indices, -1 terminated
+    vector<CellMask> region_mask;             // Per region index
+    vector<vector<int>> region_cells;         // Per region index
+    vector<int> region_size;                  // Per region index
+    vector<int> region_by_id;                 // Region id -> region index
+    vector<int> linked_region;                // Per region index, -1 if not linked
+    vector<vector<int>> linked_from;          // Per region index: regions linked to it
+    vector<Symmetry> symmetries;
+
+    CompiledLayout(const vector<Region>& regs, int r, int c) : rows(r), cols(c), regions(regs) {
+        static atomic<uint64_t> next_id{1};
+        id = next_id++;
+
+        int max_id = 0;
+        for (const auto& reg : regions) max_id = max(max_id, reg.id);
+        region_by_id.assign(max_id + 1, -1);
+        cell_to_region.assign(rows * cols, -1);
+        region_mask.assign(regions.size(), 0);
+        region_cells.assign(regions.size(), {});
+        region_size.assign(regions.size(), 0);
+
+        for (size_t i = 0; i < regions.size(); i++) {
+            region_by_id[regions[i].id] = i;
+            for (const auto& cell : regions[i].cells) {
+                int idx = cell.first * cols + cell.second;
+                cell_to_region[idx] = i;
+                region_mask[i] |= cell_bit(idx);
+                region_cells[i].push_back(idx);
+                region_size[i]++;
+                if (!(board_mask & cell_bit(idx))) num_cells++;
+                board_mask |= cell_bit(idx);
+            }
+        }
 
-        for (auto& reg : regions) {
-            for (const auto& cell : reg.cells) {
-                cell_to_region[cell] = reg.id;
-                all_cells.insert(cell);
+        linked_region.assign(regions.size(), -1);
+        linked_from.assign(regions.size(), {});
+        for (size_t i = 0; i < regions.size(); i++) {
+            bool compared = regions[i].type == ConstraintType::LESS ||
+                            regions[i].type == ConstraintType::GREATER;
+            if (compared && regions[i].linked_region_id >= 0) {
+                linked_region[i] = region_by_id[regions[i].linked_region_id];
+                linked_from[linked_region[i]].push_back(i);
             }
-            region_by_id[reg.id] = const_cast<Region*>(&reg);
         }
-        // Fix region pointers after regions is done being modified
-        for (auto& reg : regions) {
-            region_by_id[reg.id] = &reg;
+
+        adjacent.assign(rows * cols, {-1, -1, -1, -1});
+        for (int row = 0; row < rows; row++) {
+            for (int col = 0; col < cols; col++) {
+                Cell candidates[] = {{row-1,col}, {row+1,col}, {row,col-1}, {row,col+1}};
+                int n = 0;
+                for (auto& cand : candidates) {
+                    if (cand.first < 0 || cand.first >= rows ||
+                        cand.second < 0 || cand.second >= cols) continue;
+                    int idx = cand.first * cols + cand.second;
+                    if (board_mask & cell_bit(idx)) adjacent[row * cols + col][n++] = idx;
+                }
+            }
         }
+
+        find_symmetries();
     }
 
-    int get_region_sum(int region_id, const map<Cell, int>& cell_values) {
-        int total = 0;
-        for (const auto& cell : region_by_id[region_id]->cells) {
-            auto it = cell_values.find(cell);
-            if (it != cell_values.end()) {
-                total += it->second;
+    // Try the involutions of the board's bounding box (reflections, the
+    // half-turn and, on square boxes, the diagonal flips) and keep those
+    // that map regions onto regions with matching types and links
+    void find_symmetries() {
+        int min_r = rows, max_r = -1, min_c = cols, max_c = -1;
+        for (int idx = 0; idx < rows * cols; idx++) {
+            if (!(board_mask & cell_bit(idx))) continue;
+            min_r = min(min_r, idx / cols); max_r = max(max_r, idx / cols);
+            min_c = min(min_c, idx % cols); max_c = max(max_c, idx % cols);
+        }
+        if (max_r < 0) return;
+
+        int n_transforms = (max_r - min_r == max_c - min_c) ? 5 : 3;
+        for (int t = 0; t < n_transforms; t++) {
+            vector<int> cell_map(rows * cols, -1);
+            bool ok = true;
+            for (int idx = 0; idx < rows * cols && ok; idx++) {
+                if (!(board_mask & cell_bit(idx))) continue;
+                int r = idx / cols - min_r, c = idx % cols - min_c;
+                int h = max_r - min_r, w = max_c - min_c;
+                int nr = r, nc = c;
+                if (t == 0) nc = w - c;
+                else if (t == 1) nr = h - r;
+                else if (t == 2) { nr = h - r; nc = w - c; }
+                else if (t == 3) { nr = c; nc = r; }
+                else { nr = w - c; nc = h - r; }
+                int image = (nr + min_r) * cols + (nc + min_c);
+                ok = board_mask & cell_bit(image);
+                cell_map[idx] = image;
+            }
+            if (!ok) continue;
+
+            vector<int> region_map(regions.size(), -1);
+            for (size_t i = 0; i < regions.size() && ok; i++) {
+                // A region without cells has no image to match
+                if (region_cells[i].empty()) {
+                    ok = false;
+                    break;
+                }
+                CellMask image = 0;
+                for (int idx : region_cells[i]) image |= cell_bit(cell_map[idx]);
+                int j = cell_to_region[cell_map[region_cells[i][0]]];
+                ok = region_mask[j] == image;
+                region_map[i] = j;
+            }
+            for (size_t i = 0; i < regions.size() && ok; i++) {
+                const Region& a = regions[i];
+                const Region& b = regions[region_map[i]];
+                ok = a.type == b.type;
+                bool compared = a.type == ConstraintType::LESS || a.type == ConstraintType::GREATER;
+                if (ok && compared && (a.linked_region_id >= 0 || b.linked_region_id >= 0)) {
+                    ok = a.linked_region_id >= 0 && b.linked_region_id >= 0 &&
+                         region_by_id[b.linked_region_id] ==
+                         region_map[region_by_id[a.linked_region_id]];
+                }
+            }
+            if (!ok) continue;
+
+            for (int idx = 0; idx < rows * cols; idx++) {
+                if ((board_mask & cell_bit(idx)) && cell_map[idx] != idx) {
+                    int image = cell_map[idx];
+                    symmetries.push_back({move(cell_map), move(region_map), idx, image});
+                    break;
+                }
             }
         }
-        return total;
+    }
+};
+
+// Solver class
+class Solver {
+public:
+    vector<Domino> dominoes;
+    vector<Region> regions;
+    int rows = 0, cols = 0;
+    int max_solutions = 2;
+    int max_pip = 0;
+
+    // Dense board tables, indexed by row * cols + col, from the layout
+    uint64_t layout_id = 0;                   // CompiledLayout::id, 0 before the first load
+    int num_cells = 0;
+    CellMask board_mask = 0;
+    vector<int> cell_to_region;               // Region index, -1 if off-board
+    vector<array<int, 4>> adjacent;           // Neighbor indices, -1 terminated
+    vector<CellMask> region_mask;             // Per region index
+    vector<vector<int>> region_cells;         // Per region index
+    vector<int> region_size;                  // Per region index
+    vector<int> region_by_id;                 // Region id -> region index
+    vector<int> linked_region;                // Per region index, -1 if not linked
+    vector<vector<int>> linked_from;          // Per region index: regions linked to it
+
+    // Distinct fillings found. Uniqueness only needs 0, 1 or >= 2, so the
+    // first filling is kept as its pip array and placements, and any later
+    // ones are told apart by a 64-bit hash of their pips.
+    int solution_count = 0;
+    array<uint8_t, MAX_CELLS> first_pips{};
+    vector<PlacedDomino> first_solution;
+    unordered_set<uint64_t> seen_hashes;      // Only used when max_solutions > 2
+    uint64_t first_hash = 0;                  // Zobrist pip hash of the first filling
+    bool keep_second = false;                 // Also keep the second filling's pips
+    array<uint8_t, MAX_CELLS> second_pips{};
+    SearchStats stats;                        // Of the last solve
+    SolverState scratch;                      // Reused by each solve
+    bool instrument = telemetry.enabled;      // Attribute pruned placements
+
+    // Backtracking consults the thread's transposition table when the
+    // solve only needs 0, 1 or 2+ fillings; the hashes are kept just then
+    bool transpose = false;
+    uint64_t puzzle_key = 0;                  // Dominoes, regions and targets
+    static constexpr int TT_MIN_OPEN = 6;     // Open cells below which nodes are not hashed
+
+    // Parallel solves: while the tree is split, nodes split_depth
+    // placements deep (and complete fillings) are saved to frontier as
+    // their placements instead of searched; each task then replays one of
+    // them onto a state of its own and searches on, recording into shared
+    vector<vector<PlacedDomino>>* frontier = nullptr;
+    size_t split_depth = 0;
+    SharedSolutions* shared = nullptr;
+    static constexpr size_t MIN_TASKS_PER_WORKER = 8;
+
+    // Sweep mode: open SUM regions are unconstrained and every filling is
+    // tallied under the tuple of sums it gives those regions
+    bool sweep = false;
+    vector<int> open_regions;                 // Region indices, in region order
+    // The first sweep_used entries are this solve's; the rest are kept for
+    // their buffers. sweep_index hashes a tuple to its entry (-1 if empty).
+    vector<SweepEntry> sweep_entries;
+    size_t sweep_used = 0;
+    vector<int> sweep_index;
+    vector<const SweepEntry*> sweep_sorted;
+    vector<int> sweep_key, mirror_key;
+
+    // Symmetry breaking: a board reflection or half-turn that maps the
+    // puzzle, constraints included, onto itself. Only fillings with
+    // pip(sym_cell) <= pip(sym_image) are searched; one with a strict <
+    // stands for itself and its distinct mirror image.
+    bool use_symmetry = false;
+    int sym_cell = -1, sym_image = -1;
+    vector<int> sym_cell_map;                 // Dense cell index -> image
+    vector<int> sym_region_map;               // Region index -> image region
+    array<uint8_t, MAX_CELLS> mirror_pips{};
+    vector<PlacedDomino> mirror_placed;
+
+    Solver() = default;
+
+    Solver(const vector<Domino>& doms, const vector<Region>& regs, int r, int c, int max_sol = 2) {
+        load(CompiledLayout(regs, r, c), doms, regs, max_sol);
     }
 
-    vector<int> get_region_values(int region_id, const map<Cell, int>& cell_values) {
-        vector<int> vals;
-        for (const auto& cell : region_by_id[region_id]->cells) {
-            auto it = cell_values.find(cell);
-            if (it != cell_values.end()) {
-                vals.push_back(it->second);
+    // Set up a solve of layout with these dominoes and the targets of regs,
+    // the layout's regions with only their targets changed. The board
+    // tables are copied only when the layout is not the one loaded last,
+    // and every buffer is kept, so reloading a thread's solver for each
+    // attempt allocates nothing once warm.
+    void load(const CompiledLayout& layout, const vector<Domino>& doms, const vector<Region>& regs,
+              int max_sol = 2) {
+        if (layout.id != layout_id) {
+            layout_id = layout.id;
+            rows = layout.rows;
+            cols = layout.cols;
+            regions = layout.regions;
+            num_cells = layout.num_cells;
+            board_mask = layout.board_mask;
+            cell_to_region = layout.cell_to_region;
+            adjacent = layout.adjacent;
+            region_mask = layout.region_mask;
+            region_cells = layout.region_cells;
+            region_size = layout.region_size;
+            region_by_id = layout.region_by_id;
+            linked_region = layout.linked_region;
+            linked_from = layout.linked_from;
+        }
+        dominoes = doms;
+        max_solutions = max_sol;
+        max_pip = 0;
+        for (const auto& d : dominoes) max_pip = max(max_pip, d.high);
+        open_regions.clear();
+        for (size_t i = 0; i < regions.size(); i++) {
+            regions[i].target_value = regs[i].target_value;
+            if (regions[i].type == ConstraintType::SUM && regions[i].target_value == OPEN_TARGET) {
+                open_regions.push_back(i);
             }
         }
-        return vals;
+        reset();
+        first_solution.reserve(dominoes.size());
+        keep_second = false;
+        sweep = false;
+        instrument = telemetry.enabled;
+        stats = {};
+
+        // Mirrored counts are only exact up to two solutions
+        use_symmetry = false;
+        if (max_solutions <= 2) choose_symmetry(layout);
     }
 
-    bool is_region_complete(int region_id, const set<Cell>& filled) {
-        for (const auto& cell : region_by_id[region_id]->cells) {
-            if (filled.find(cell) == filled.end()) return false;
+    // The first of the layout's symmetries that also maps each sum and
+    // threshold region onto one with the same target
+    void choose_symmetry(const CompiledLayout& layout) {
+        for (const auto& sym : layout.symmetries) {
+            bool ok = true;
+            for (size_t i = 0; i < regions.size() && ok; i++) {
+                const Region& a = regions[i];
+                const Region& b = regions[sym.region_map[i]];
+                bool threshold = (a.type == ConstraintType::LESS || a.type == ConstraintType::GREATER) &&
+                                 a.linked_region_id < 0;
+                if (threshold || a.type == ConstraintType::SUM) ok = a.target_value == b.target_value;
+            }
+            if (!ok) continue;
+            use_symmetry = true;
+            sym_cell = sym.cell;
+            sym_image = sym.image;
+            sym_cell_map = sym.cell_map;
+            sym_region_map = sym.region_map;
+            mirror_placed.reserve(dominoes.size());
+            return;
         }
-        return true;
     }
 
-    bool check_constraint(const Region& region, const map<Cell, int>& cell_values,
-                         const set<Cell>& filled, bool partial_ok = true) {
-        bool complete = is_region_complete(region.id, filled);
+    int index_of(Cell cell) const { return cell.first * cols + cell.second; }
+
+    // Board and pip bounds of shape S, compile-time constants when it fixes
+    // them. A fixed shape's grid neighbors include off-board cells, so
+    // callers mask them with board_mask.
+    template <class S> int grid_cells() const {
+        if constexpr (S::fixed_board) return S::cells; else return rows * cols;
+    }
+    template <class S> int stride() const {
+        if constexpr (S::fixed_board) return S::cols; else return cols;
+    }
+    template <class S> const array<int, 4>& neighbors(int idx) const {
+        if constexpr (S::fixed_board) return S::neighbors[idx]; else return adjacent[idx];
+    }
+    template <class S> int pip_bound() const {
+        if constexpr (S::max_pip > 0) return S::max_pip; else return max_pip;
+    }
+
+    // Whether shape S describes this board and covers its pips
+    template <class S> bool fits() const {
+        return (!S::fixed_board || (rows == S::rows && cols == S::cols)) &&
+               (S::max_pip == 0 || max_pip <= S::max_pip);
+    }
+
+    int get_region_sum(int rix, const SolverState& state) const {
+        return state.region_tally[rix].sum;
+    }
+
+    bool is_region_complete(int rix, const SolverState& state) const {
+        return state.region_tally[rix].filled == region_size[rix];
+    }
+
+    bool check_constraint(int rix, const SolverState& state, bool partial_ok = true) const {
+        const Region& region = regions[rix];
+        bool complete = is_region_complete(rix, state);
 
         if (region.type == ConstraintType::SUM) {
-            int sum = get_region_sum(region.id, cell_values);
+            if (region.target_value == OPEN_TARGET) return true;
+            int sum = get_region_sum(rix, state);
             if (complete) return sum == region.target_value;
             return partial_ok && sum <= region.target_value;
         }
         else if (region.type == ConstraintType::EQUAL) {
-            auto vals = get_region_values(region.id, cell_values);
-            if (vals.empty()) return true;
-            int first = vals[0];
-            for (int v : vals) {
-                if (v != first) return false;
-            }
-            return true;
+            return state.region_tally[rix].mismatches == 0;
         }
-        else if (region.type == ConstraintType::LESS) {
-            if (!complete) return partial_ok;
-            if (!is_region_complete(region.linked_region_id, filled)) return partial_ok;
-            int my_sum = get_region_sum(region.id, cell_values);
-            int their_sum = get_region_sum(region.linked_region_id, cell_values);
-            return my_sum < their_sum;
+        else if (region.type == ConstraintType::UNEQUAL) {
+            return state.region_tally[rix].repeats == 0;
         }
-        else if (region.type == ConstraintType::GREATER) {
+        else if (region.linked_region_id < 0 &&
+                 (region.type == ConstraintType::LESS || region.type == ConstraintType::GREATER)) {
+            // Threshold: pips never go negative, so a partial sum bounds the
+            // final one from below and the empty cells at max_pip from above
+            if (!complete && !partial_ok) return false;
+            int sum = get_region_sum(rix, state);
+            if (region.type == ConstraintType::LESS) return sum < region.target_value;
+            int open = region_size[rix] - state.region_tally[rix].filled;
+            return sum + open * max_pip > region.target_value;
+        }
+        else if (region.type == ConstraintType::LESS || region.type == ConstraintType::GREATER) {
+            int linked = region_by_id[region.linked_region_id];
             if (!complete) return partial_ok;
-            if (!is_region_complete(region.linked_region_id, filled)) return partial_ok;
-            int my_sum = get_region_sum(region.id, cell_values);
-            int their_sum = get_region_sum(region.linked_region_id, cell_values);
-            return my_sum > their_sum;
+            if (!is_region_complete(linked, state)) return partial_ok;
+            int my_sum = get_region_sum(rix, state);
+            int their_sum = get_region_sum(linked, state);
+            return region.type == ConstraintType::LESS ? my_sum < their_sum : my_sum > their_sum;
         }
         return true;
     }
 
-    vector<Cell> get_adjacent(Cell cell) {
-        vector<Cell> adj;
-        int r = cell.first, c = cell.second;
-        Cell candidates[] = {{r-1,c}, {r+1,c}, {r,c-1}, {r,c+1}};
-        for (auto& n : candidates) {
-            if (all_cells.count(n)) adj.push_back(n);
+    // Smallest and largest total of k pips drawn from the supply left
+    template <class S = GenericShape>
+    int supply_low(const SolverState& state, int k) const {
+        int total = 0;
+        for (int p = 0; k > 0 && p <= pip_bound<S>(); p++) {
+            int take = min(k, (int)state.supply[p]);
+            total += take * p;
+            k -= take;
         }
-        return adj;
+        return total;
     }
 
-    Cell choose_cell(const SolverState& state) {
-        Cell best = {-1, -1};
-        int min_unfilled = INT_MAX;
-
-        for (const auto& cell : all_cells) {
-            if (state.filled_cells.count(cell)) continue;
-
-            int rid = cell_to_region[cell];
-            int unfilled = 0;
-            for (const auto& c : region_by_id[rid]->cells) {
-                if (!state.filled_cells.count(c)) unfilled++;
-            }
-            if (unfilled < min_unfilled) {
-                min_unfilled = unfilled;
-                best = cell;
-            }
+    template <class S = GenericShape>
+    int supply_high(const SolverState& state, int k) const {
+        int total = 0;
+        for (int p = pip_bound<S>(); k > 0 && p >= 0; p--) {
+            int take = min(k, (int)state.supply[p]);
+            total += take * p;
+            k -= take;
         }
-        return best;
+        return total;
+    }
+
+    // Bounds on the total a region will end up with
+    template <class S = GenericShape>
+    int final_low(int rix, const SolverState& state) const {
+        const RegionTally& t = state.region_tally[rix];
+        return t.sum + supply_low<S>(state, region_size[rix] - t.filled);
     }
 
-    void backtrack(SolverState& state) {
-        if (solutions.size() >= (size_t)max_solutions) return;
+    template <class S = GenericShape>
+    int final_high(int rix, const SolverState& state) const {
+        const RegionTally& t = state.region_tally[rix];
+        return t.sum + supply_high<S>(state, region_size[rix] - t.filled);
+    }
 
-        if (state.filled_cells.size() == all_cells.size()) {
-            // Verify all constraints
-            for (const auto& region : regions) {
-                if (!check_constraint(region, state.cell_values, state.filled_cells, false)) {
-                    return;
+    // Pips an open cell of region rix can still take: those left in the
+    // supply that keep every constraint on the region satisfiable, its own
+    // and those of regions compared with it. The region's open cells all
+    // share this domain. 0 means the region can no longer be completed.
+    template <class S = GenericShape>
+    uint16_t region_domain(int rix, const SolverState& state) const {
+        const Region& region = regions[rix];
+        const RegionTally& t = state.region_tally[rix];
+        int open = region_size[rix] - t.filled;
+        uint16_t domain = state.supply_mask;
+
+        // Window for the final total; a cell holding p leaves the other
+        // open cells between lo_rest and hi_rest
+        int min_total = 0, max_total = INT_MAX / 2;
+        switch (region.type) {
+            case ConstraintType::SUM:
+                if (region.target_value != OPEN_TARGET) min_total = max_total = region.target_value;
+                break;
+            case ConstraintType::EQUAL:
+                if (t.equal_ref >= 0) {
+                    if (state.supply[t.equal_ref] < open) return 0;
+                    domain &= 1u << t.equal_ref;
+                } else {
+                    for (int p = 0; p <= pip_bound<S>(); p++) {
+                        if (state.supply[p] < open) domain &= ~(1u << p);
+                    }
                 }
+                break;
+            case ConstraintType::UNEQUAL:
+                domain &= ~t.seen_pips;
+                if (__builtin_popcount(domain) < open) return 0;
+                break;
+            case ConstraintType::LESS:
+                if (linked_region[rix] < 0) max_total = region.target_value - 1;
+                else max_total = final_high<S>(linked_region[rix], state) - 1;
+                break;
+            case ConstraintType::GREATER:
+                if (linked_region[rix] < 0) min_total = region.target_value + 1;
+                else min_total = final_low<S>(linked_region[rix], state) + 1;
+                break;
+            case ConstraintType::EMPTY:
+                break;
+        }
+        for (int q : linked_from[rix]) {
+            if (regions[q].type == ConstraintType::LESS) {
+                min_total = max(min_total, final_low<S>(q, state) + 1);
+            } else {
+                max_total = min(max_total, final_high<S>(q, state) - 1);
             }
-            // Deduplicate
-            if (seen_signatures.insert(state.cell_values).second) {
-                solutions.push_back(state);
-            }
-            return;
         }
+        if (min_total > max_total) return 0;
 
-        Cell cell = choose_cell(state);
-        if (cell.first < 0) return;
-
-        for (const auto& domino : dominoes) {
-            if (state.used_dominoes.count(domino)) continue;
+        int lo_rest = supply_low<S>(state, open - 1), hi_rest = supply_high<S>(state, open - 1);
+        int lo = max(0, min_total - t.sum - hi_rest);
+        int hi = min(15, max_total - t.sum - lo_rest);
+        if (lo > hi) return 0;
+        return domain & (uint16_t)(((2u << hi) - 1) & ~((1u << lo) - 1));
+    }
 
-            for (const auto& adj : get_adjacent(cell)) {
-                if (state.filled_cells.count(adj)) continue;
-                if (!cell_to_region.count(cell) || !cell_to_region.count(adj)) continue;
+    // Forward check after a placement on cells a and b: the regions they
+    // lie in and the regions compared with those must each still have pips
+    // for their open cells. Returns the first region left without any, or -1.
+    template <class S = GenericShape>
+    int starved_region(const SolverState& state, int a, int b) const {
+        for (int rix : {cell_to_region[a], cell_to_region[b]}) {
+            if (!open_with_domain<S>(rix, state)) return rix;
+            int linked = linked_region[rix];
+            if (linked >= 0 && !open_with_domain<S>(linked, state)) return linked;
+            for (int q : linked_from[rix]) {
+                if (!open_with_domain<S>(q, state)) return q;
+            }
+        }
+        return -1;
+    }
 
-                // Try both orientations
-                vector<pair<int,int>> orientations = {{domino.low, domino.high}};
-                if (domino.low != domino.high) {
-                    orientations.push_back({domino.high, domino.low});
-                }
-
-                for (auto [pip_cell, pip_adj] : orientations) {
-                    map<Cell, int> new_values = state.cell_values;
-                    new_values[cell] = pip_cell;
-                    new_values[adj] = pip_adj;
-
-                    set<Cell> new_filled = state.filled_cells;
-                    new_filled.insert(cell);
-                    new_filled.insert(adj);
-
-                    // Check constraints
-                    bool valid = true;
-                    set<int> affected = {cell_to_region[cell], cell_to_region[adj]};
-                    for (int rid : affected) {
-                        if (!check_constraint(*region_by_id[rid], new_values, new_filled, true)) {
-                            valid = false;
-                            break;
-                        }
-                    }
-                    if (!valid) continue;
+    template <class S = GenericShape>
+    uint16_t cell_domain(int idx, const SolverState& state) const {
+        return region_domain<S>(cell_to_region[idx], state);
+    }
 
-                    // Create placement
-                    bool horiz = (cell.first == adj.first);
-                    int pr = min(cell.first, adj.first);
-                    int pc = min(cell.second, adj.second);
-                    PlacedDomino placement{domino, pr, pc, horiz};
+    // True when region rix is complete or its open cells have a domain
+    template <class S = GenericShape>
+    bool open_with_domain(int rix, const SolverState& state) const {
+        return state.region_tally[rix].filled == region_size[rix] || region_domain<S>(rix, state);
+    }
 
-                    SolverState new_state;
-                    new_state.placed = state.placed;
-                    new_state.placed.push_back(placement);
-                    new_state.used_dominoes = state.used_dominoes;
-                    new_state.used_dominoes.insert(domino);
-                    new_state.filled_cells = new_filled;
-                    new_state.cell_values = new_values;
+    // Region checks for a domino just placed on cells a and b, the forward
+    // check, and the symmetry-breaking order once both symmetric cells are
+    // filled
+    template <class S = GenericShape>
+    bool placement_ok(const SolverState& state, int a, int b) const {
+        int ra = cell_to_region[a], rb = cell_to_region[b];
+        if (!check_constraint(ra, state, true)) return false;
+        if (rb != ra && !check_constraint(rb, state, true)) return false;
+        if (starved_region<S>(state, a, b) >= 0) return false;
+        if (!use_symmetry) return true;
+        CellMask both = cell_bit(sym_cell) | cell_bit(sym_image);
+        return (state.filled_cells & both) != both ||
+               state.cell_values[sym_cell] <= state.cell_values[sym_image];
+    }
 
-                    backtrack(new_state);
+    // Charge a placement placement_ok() rejected to the check that failed
+    void count_pruned(SolverState& state, int a, int b) const {
+        int ra = cell_to_region[a], rb = cell_to_region[b];
+        int reason = PRUNED_BY_SYMMETRY;
+        int starved = -1;
+        if (!check_constraint(ra, state, true)) reason = (int)regions[ra].type;
+        else if (rb != ra && !check_constraint(rb, state, true)) reason = (int)regions[rb].type;
+        else if ((starved = starved_region(state, a, b)) >= 0) reason = (int)regions[starved].type;
+        state.stats.pruned[reason]++;
+    }
 
-                    if (solutions.size() >= (size_t)max_solutions) return;
-                }
+    // Region domains of one search node, each computed on first use
+    template <class S = GenericShape>
+    class DomainCache {
+    public:
+        DomainCache(const Solver& solver, const SolverState& state) : solver(solver), state(state) {}
+
+        uint16_t of_cell(int idx) {
+            int rix = solver.cell_to_region[idx];
+            if (!(known & cell_bit(rix))) {
+                domain[rix] = solver.template region_domain<S>(rix, state);
+                known |= cell_bit(rix);
             }
+            return domain[rix];
+        }
+
+    private:
+        const Solver& solver;
+        const SolverState& state;
+        array<uint16_t, MAX_CELLS> domain;
+        CellMask known = 0;   // By region index
+    };
+
+    // Mark domino d placed or unplaced, keeping pair_count and partners
+    void take_domino(SolverState& state, int d) const {
+        const Domino& domino = dominoes[d];
+        state.used_dominoes |= 1ull << d;
+        if (transpose) state.fill_hash ^= zobrist(Z_DOMINO | d);
+        if (--state.pair_count[domino.low * 16 + domino.high] == 0) {
+            state.partners[domino.low] &= ~(1u << domino.high);
+            state.partners[domino.high] &= ~(1u << domino.low);
         }
     }
 
-    int solve() {
-        solutions.clear();
-        seen_signatures.clear();
-        SolverState initial;
-        backtrack(initial);
-        return solutions.size();
+    void return_domino(SolverState& state, int d) const {
+        const Domino& domino = dominoes[d];
+        state.used_dominoes &= ~(1ull << d);
+        if (transpose) state.fill_hash ^= zobrist(Z_DOMINO | d);
+        if (state.pair_count[domino.low * 16 + domino.high]++ == 0) {
+            state.partners[domino.low] |= 1u << domino.high;
+            state.partners[domino.high] |= 1u << domino.low;
+        }
     }
-};
 
-// Test a puzzle configuration
-int test_puzzle(const vector<Domino>& dominoes, int rows, int cols,
-                vector<Region> regions, vector<PlacedDomino>* solution_out = nullptr) {
-    Solver solver(dominoes, regions, rows, cols, 3);
-    int count = solver.solve();
-    if (count == 1 && solution_out) {
-        *solution_out = solver.solutions[0].placed;
+    // Ways to put an unplaced domino across two cells with pip domains da
+    // and db, as distinct (pip on the first, pip on the second) pairs;
+    // duplicate dominoes give the same filling, so they count once
+    int pair_options(const SolverState& state, uint16_t da, uint16_t db) const {
+        int options = 0;
+        for (uint16_t m = da; m; m &= m - 1) {
+            options += __builtin_popcount(state.partners[__builtin_ctz(m)] & db);
+        }
+        return options;
     }
-    return count;
-}
 
-// Generate all combinations of n items from vec
-template<typename T>
-void combinations(const vector<T>& vec, int n, int start,
-                 vector<T>& current, vector<vector<T>>& result) {
-    if ((int)current.size() == n) {
-        result.push_back(current);
-        return;
+    // Most constrained empty cell: the one with the fewest placement
+    // options over its free neighbors, ties going to the region with the
+    // fewest unfilled cells. Sets dead_end instead once some empty cell
+    // has no option at all, such as one with no free neighbor.
+    template <class S = GenericShape>
+    int choose_cell(const SolverState& state, bool& dead_end) const {
+        int best = -1;
+        int min_options = INT_MAX, min_unfilled = INT_MAX;
+        DomainCache<S> domains(*this, state);
+        auto domain_of = [&](int idx) { return domains.of_cell(idx); };
+
+        CellMask empty = board_mask & ~state.filled_cells;
+        for (int idx = 0; idx < grid_cells<S>(); idx++) {
+            if (!(empty & cell_bit(idx))) continue;
+
+            uint16_t dom = domain_of(idx);
+            int options = 0;
+            for (int adj : neighbors<S>(idx)) {
+                if (adj < 0) break;
+                if (dom && (empty & cell_bit(adj))) options += pair_options(state, dom, domain_of(adj));
+            }
+            if (options == 0) {
+                dead_end = true;
+                return -1;
+            }
+            int rix = cell_to_region[idx];
+            int unfilled = region_size[rix] - state.region_tally[rix].filled;
+            if (options < min_options || (options == min_options && unfilled < min_unfilled)) {
+                min_options = options;
+                min_unfilled = unfilled;
+                best = idx;
+            }
+        }
+        return best;
     }
-    for (int i = start; i < (int)vec.size(); i++) {
-        current.push_back(vec[i]);
-        combinations(vec, n, i + 1, current, result);
-        current.pop_back();
+
+    void set_cell(SolverState& state, int idx, int pip) const {
+        if (--state.supply[pip] == 0) state.supply_mask &= ~(1u << pip);
+        state.cell_values[idx] = pip;
+        state.filled_cells |= cell_bit(idx);
+        if (transpose) {
+            state.pip_hash ^= zobrist(Z_PIP | idx << 4 | pip);
+            state.fill_hash ^= zobrist(Z_CELL | idx);
+        }
+        RegionTally& t = state.region_tally[cell_to_region[idx]];
+        t.sum += pip;
+        if (t.filled++ == 0) t.equal_ref = pip;
+        else if (pip != t.equal_ref) t.mismatches++;
+        if (t.seen_pips & (1u << pip)) {
+            t.repeats++;
+            state.repeated_cells |= cell_bit(idx);
+        } else {
+            t.seen_pips |= 1u << pip;
+        }
     }
-}
 
-template<typename T>
-vector<vector<T>> get_combinations(const vector<T>& vec, int n) {
-    vector<vector<T>> result;
-    vector<T> current;
-    combinations(vec, n, 0, current, result);
-    return result;
-}
+    // Must undo set_cell() calls in reverse order so equal_ref and
+    // seen_pips stay valid
+    void clear_cell(SolverState& state, int idx) const {
+        int pip = state.cell_values[idx];
+        if (state.supply[pip]++ == 0) state.supply_mask |= 1u << pip;
+        RegionTally& t = state.region_tally[cell_to_region[idx]];
+        t.sum -= pip;
+        if (--t.filled == 0) t.equal_ref = -1;
+        else if (pip != t.equal_ref) t.mismatches--;
+        if (state.repeated_cells & cell_bit(idx)) {
+            t.repeats--;
+            state.repeated_cells &= ~cell_bit(idx);
+        } else {
+            t.seen_pips &= ~(1u << pip);
+        }
+        if (transpose) {
+            state.pip_hash ^= zobrist(Z_PIP | idx << 4 | pip);
+            state.fill_hash ^= zobrist(Z_CELL | idx);
+        }
+        state.cell_values[idx] = 0;
+        state.filled_cells &= ~cell_bit(idx);
+    }
 
-// Search functions for each difficulty
-void search_easy_2x4_sums(int thread_id, const vector<Domino>& all_d6) {
-    // 2x4 grid with 4 dominoes - try inequality chain with 4 regions
-    int rows = 2, cols = 4;
+    void place(SolverState& state, int a, int b, int pip_a, int pip_b) const {
+        state.stats.nodes++;
+        set_cell(state, a, pip_a);
+        set_cell(state, b, pip_b);
+    }
 
-    // 4 regions of 2 cells each with inequality chain
-    vector<Cell> region0 = {{0,0}, {0,1}};
-    vector<Cell> region1 = {{0,2}, {0,3}};
-    vector<Cell> region2 = {{1,0}, {1,1}};
-    vector<Cell> region3 = {{1,2}, {1,3}};
+    void unplace(SolverState& state, int a, int b) const {
+        clear_cell(state, b);
+        clear_cell(state, a);
+    }
 
-    auto combos = get_combinations(all_d6, 4);
+    template <class S = GenericShape>
+    void backtrack(SolverState& state, int filled_count) {
+        if (done()) return;
 
-    for (size_t i = thread_id; i < combos.size(); i += 4) {
-        if (found_easy1.load()) return;
+        if (frontier && (state.placed.size() == split_depth || filled_count == num_cells)) {
+            frontier->push_back(state.placed);
+            return;
+        }
+        if (filled_count == num_cells) {
+            record_solution(state);
+            return;
+        }
+        if (!transpose || num_cells - filled_count < TT_MIN_OPEN) {
+            expand<S>(state, filled_count);
+            return;
+        }
 
-        const auto& dominoes = combos[i];
-        int total = 0;
-        for (const auto& d : dominoes) total += d.pips();
-
-        // Try inequality chain A < B < C < D with different sum targets for D
-        for (int target3 = 1; target3 <= 12; target3++) {
-            if (found_easy1.load()) return;
-            total_attempts++;
-
-            vector<Region> regions = {
-                {0, region0, ConstraintType::LESS, -1, 1},
-                {1, region1, ConstraintType::LESS, -1, 2},
-                {2, region2, ConstraintType::LESS, -1, 3},
-                {3, region3, ConstraintType::SUM, target3, -1}
-            };
+        uint64_t key = subproblem_key(state);
+        state.stats.tt_probes++;
+        const TranspositionTable::Entry* entry = transpositions.probe(key);
+        if (entry && replay(state, *entry)) {
+            state.stats.tt_hits++;
+            return;
+        }
 
-            vector<PlacedDomino> solution;
-            int count = test_puzzle(dominoes, rows, cols, regions, &solution);
+        // Tally this node's completions on their own, then fold them into
+        // the enclosing node's. A search cut short by done() has only a
+        // lower bound, which is worth keeping once it reaches 2.
+        Completions outer = state.completions;
+        state.completions = {};
+        expand<S>(state, filled_count);
+        Completions inner = state.completions;
+        if (!done() || inner.count >= 2) {
+            transpositions.store(key, inner, inner.hash ^ state.pip_hash);
+        }
+        state.completions = outer;
+        if (inner.count) tally(state, inner);
+    }
 
-            if (count == 1) {
-                lock_guard<mutex> lock(result_mutex);
-                if (!found_easy1.load()) {
-                    found_easy1 = true;
-                    easy1_result = PuzzleResult{
-                        dominoes, regions, rows, cols, "Easy1_IneqChain", solution
-                    };
-                    cout << "[Thread " << thread_id << "] Found Easy1! Attempts: "
-                         << total_attempts.load() << endl;
-                    print_result("EASY PUZZLE 1", easy1_result);
-                    cout << flush;
+    // Zobrist key of the subproblem at this node. Regions contribute what
+    // their constraints read: sums, the pip an EQUAL region is held to and
+    // the pips an UNEQUAL region has used.
+    uint64_t subproblem_key(const SolverState& state) const {
+        uint64_t key = state.fill_hash ^ puzzle_key;
+        for (size_t rix = 0; rix < regions.size(); rix++) {
+            const RegionTally& t = state.region_tally[rix];
+            if (t.filled == 0) continue;
+            uint64_t value;
+            switch (regions[rix].type) {
+                case ConstraintType::EQUAL: value = t.equal_ref; break;
+                case ConstraintType::UNEQUAL: value = t.seen_pips; break;
+                case ConstraintType::EMPTY: continue;
+                default: value = t.sum; break;
+            }
+            key ^= zobrist(Z_REGION | rix << 16 | value);
+        }
+        if (use_symmetry) {
+            for (int idx : {sym_cell, sym_image}) {
+                if (state.filled_cells & cell_bit(idx)) {
+                    key ^= zobrist(Z_PIP | idx << 4 | state.cell_values[idx]);
                 }
-                return;
             }
         }
+        return key | 1;
     }
-}
-
-void search_easy_3cell_regions(int thread_id, const vector<Domino>& pool) {
-    // 2x4 grid with 3-cell regions (forces spanning)
-    int rows = 2, cols = 4;
 
-    vector<Cell> region0 = {{0,0}, {0,1}, {1,0}};  // 3 cells
-    vector<Cell> region1 = {{0,2}, {0,3}, {1,3}};  // 3 cells
-    vector<Cell> region2 = {{1,1}, {1,2}};          // 2 cells
-
-    auto combos = get_combinations(pool, 4);
-
-    for (size_t i = thread_id; i < combos.size(); i += 4) {
-        if (found_easy2.load()) return;
+    // Count a subproblem's completions without searching it, as
+    // record_solution() would have counted the fillings they give. False
+    // when the search is still needed: with nothing found yet, the first
+    // filling's placements have to come from the search itself.
+    bool replay(SolverState& state, const TranspositionTable::Entry& entry) {
+        if (entry.count == 0) return true;
+        if (solution_count == 0) return false;
+        uint64_t hash = entry.completion ^ state.pip_hash;
+        if (entry.count >= 2) solution_count = max(solution_count, 2);
+        else if (hash != first_hash) solution_count += entry.mirrored ? 2 : 1;
+        tally(state, {entry.count, hash, entry.mirrored});
+        return true;
+    }
 
-        const auto& dominoes = combos[i];
-        int total = 0;
-        for (const auto& d : dominoes) total += d.pips();
-
-        // Try different sum combinations
-        for (int t0 = 0; t0 <= total; t0++) {
-            for (int t1 = 0; t1 <= total - t0; t1++) {
-                if (found_easy2.load()) return;
-
-                int t2 = total - t0 - t1;
-                total_attempts++;
-
-                vector<Region> regions = {
-                    {0, region0, ConstraintType::SUM, t0, -1},
-                    {1, region1, ConstraintType::SUM, t1, -1},
-                    {2, region2, ConstraintType::SUM, t2, -1}
-                };
-
-                vector<PlacedDomino> solution;
-                int count = test_puzzle(dominoes, rows, cols, regions, &solution);
-
-                if (count == 1) {
-                    lock_guard<mutex> lock(result_mutex);
-                    if (!found_easy2.load()) {
-                        found_easy2 = true;
-                        easy2_result = PuzzleResult{
-                            dominoes, regions, rows, cols, "Easy2_ForcedSpan", solution
-                        };
-                        cout << "[Thread " << thread_id << "] Found Easy2! Attempts: "
-                             << total_attempts.load() << endl;
-                        print_result("EASY PUZZLE 2", easy2_result);
-                        cout << flush;
-                    }
-                    return;
-                }
-            }
-        }
+    // Add found fillings to the innermost tally
+    static void tally(SolverState& state, const Completions& found) {
+        Completions& c = state.completions;
+        if (c.count == 0) c = found;
+        else if (found.count >= 2 || found.hash != c.hash) c.count = 2;
     }
-}
 
-void search_medium(int thread_id, const vector<Domino>& all_d6) {
-    // 3x4 grid with 6 dominoes - use 6 regions of 2 cells with inequality chain
-    int rows = 3, cols = 4;
+    template <class S = GenericShape>
+    void expand(SolverState& state, int filled_count) {
+        bool dead_end = false;
+        int cell = choose_cell<S>(state, dead_end);
+        if (dead_end) state.stats.dead_ends++;
+        if (cell < 0) return;
+        const array<int, 4>& adj_cells = neighbors<S>(cell);
+        CellMask empty = board_mask & ~state.filled_cells;
+        uint16_t cell_dom = cell_domain<S>(cell, state);
+        array<uint16_t, 4> adj_dom{};
+        for (int k = 0; k < 4 && adj_cells[k] >= 0; k++) {
+            if (empty & cell_bit(adj_cells[k])) adj_dom[k] = cell_domain<S>(adj_cells[k], state);
+        }
 
-    // 6 regions of 2 cells each - horizontal pairs
-    vector<Cell> region0 = {{0,0}, {0,1}};
-    vector<Cell> region1 = {{0,2}, {0,3}};
-    vector<Cell> region2 = {{1,0}, {1,1}};
-    vector<Cell> region3 = {{1,2}, {1,3}};
-    vector<Cell> region4 = {{2,0}, {2,1}};
-    vector<Cell> region5 = {{2,2}, {2,3}};
+        bool placed_any = false;
+        for (size_t d = 0; d < dominoes.size(); d++) {
+            if (state.used_dominoes & (1ull << d)) continue;
+            const Domino& domino = dominoes[d];
 
-    auto combos = get_combinations(all_d6, 6);
+            for (int k = 0; k < 4; k++) {
+                int adj = adj_cells[k];
+                if (adj < 0) break;
+                if (!(empty & cell_bit(adj))) continue;
 
-    for (size_t i = thread_id; i < combos.size(); i += 4) {
-        if (found_medium.load()) return;
+                // Try both orientations
+                int n_orient = (domino.low != domino.high) ? 2 : 1;
+                for (int o = 0; o < n_orient; o++) {
+                    int pip_cell = o == 0 ? domino.low : domino.high;
+                    int pip_adj = o == 0 ? domino.high : domino.low;
+                    if (!(cell_dom & (1u << pip_cell)) || !(adj_dom[k] & (1u << pip_adj))) continue;
+
+                    place(state, cell, adj, pip_cell, pip_adj);
+                    if (!placement_ok<S>(state, cell, adj)) {
+                        if (instrument) count_pruned(state, cell, adj);
+                        unplace(state, cell, adj);
+                        continue;
+                    }
+                    placed_any = true;
 
-        const auto& dominoes = combos[i];
+                    // Record placement
+                    int first = min(cell, adj);
+                    bool horiz = cell / stride<S>() == adj / stride<S>();
+                    int pip_first = first == cell ? pip_cell : pip_adj;
+                    state.placed.push_back({domino, first / stride<S>(), first % stride<S>(), horiz,
+                                            pip_first != domino.low});
+                    take_domino(state, d);
 
-        // Get all domino sums
-        vector<int> sums;
-        int total = 0;
-        for (const auto& d : dominoes) {
-            sums.push_back(d.pips());
-            total += d.pips();
-        }
+                    backtrack<S>(state, filled_count + 2);
 
-        // Sort sums to check if they're distinct
-        vector<int> sorted_sums = sums;
-        sort(sorted_sums.begin(), sorted_sums.end());
+                    return_domino(state, d);
+                    state.placed.pop_back();
+                    unplace(state, cell, adj);
 
-        // For inequality chain to work well, we want distinct sums
-        bool distinct = true;
-        for (size_t j = 1; j < sorted_sums.size(); j++) {
-            if (sorted_sums[j] == sorted_sums[j-1]) {
-                distinct = false;
-                break;
+                    if (done()) return;
+                }
             }
         }
-        if (!distinct) continue;
+        if (!placed_any) state.stats.dead_ends++;
+    }
 
-        // Inequality chain: 0 < 1 < 2 < 3 < 4 < 5 with sum constraint on 5
-        int max_sum = sorted_sums.back();
-        for (int target5 = max_sum; target5 <= max_sum + 2; target5++) {
-            if (found_medium.load()) return;
-            total_attempts++;
+    // Called with every cell filled: verify all constraints and keep the
+    // filling if its pip layout has not been seen before
+    void record_solution(SolverState& state) {
+        for (size_t rix = 0; rix < regions.size(); rix++) {
+            if (!check_constraint(rix, state, false)) return;
+        }
+        bool mirrored = use_symmetry &&
+                        state.cell_values[sym_cell] < state.cell_values[sym_image];
+        if (transpose) tally(state, {1, state.pip_hash, mirrored});
+        if (sweep) {
+            sweep_key.clear();
+            for (int rix : open_regions) sweep_key.push_back(state.region_tally[rix].sum);
+            record_sweep(sweep_key, state.cell_values, state.placed);
+            if (mirrored) {
+                mirror(state);
+                record_sweep(mirror_key, mirror_pips, mirror_placed);
+            }
+            return;
+        }
+        if (shared) {
+            record_shared(state, mirrored);
+            return;
+        }
+        if (solution_count == 0) {
+            first_pips = state.cell_values;
+            first_hash = state.pip_hash;
+            first_solution.assign(state.placed.begin(), state.placed.end());
+            solution_count = mirrored ? 2 : 1;
+            if (mirrored && keep_second) {
+                for (int idx = 0; idx < rows * cols; idx++) {
+                    if (board_mask & cell_bit(idx)) second_pips[sym_cell_map[idx]] = first_pips[idx];
+                }
+            }
+            return;
+        }
+        if (state.cell_values == first_pips) return;
+        if (max_solutions > 2 && !seen_hashes.insert(hash_pips(state.cell_values)).second) return;
+        if (solution_count == 1 && keep_second) second_pips = state.cell_values;
+        solution_count += mirrored ? 2 : 1;
+    }
 
-            vector<Region> regions = {
-                {0, region0, ConstraintType::LESS, -1, 1},
-                {1, region1, ConstraintType::LESS, -1, 2},
-                {2, region2, ConstraintType::LESS, -1, 3},
-                {3, region3, ConstraintType::LESS, -1, 4},
-                {4, region4, ConstraintType::LESS, -1, 5},
-                {5, region5, ConstraintType::SUM, target5, -1}
-            };
+    // record_solution() for a parallel solve. The first solution is the one
+    // from the earliest frontier node, which the serial search would have
+    // reached first; the one it displaces still counts.
+    void record_shared(const SolverState& state, bool mirrored) {
+        lock_guard<mutex> lock(shared->m);
+        int count = shared->count.load();
+        bool earlier = count == 0 || state.task_rank < shared->first_rank;
+        if (count == 0) {
+            shared->count = mirrored ? 2 : 1;
+        } else if (state.cell_values != shared->first_pips) {
+            if (max_solutions <= 2 || shared->seen_hashes.insert(hash_pips(state.cell_values)).second) {
+                shared->count = count + (mirrored ? 2 : 1);
+            }
+            if (earlier && max_solutions > 2) shared->seen_hashes.insert(hash_pips(shared->first_pips));
+        }
+        if (!earlier) return;
+        shared->first_pips = state.cell_values;
+        shared->first_rank = state.task_rank;
+        shared->first_solution.assign(state.placed.begin(), state.placed.end());
+    }
 
-            vector<PlacedDomino> solution;
-            int count = test_puzzle(dominoes, rows, cols, regions, &solution);
+    // Image of a filling under the symmetry, into mirror_pips/_placed/_key
+    void mirror(const SolverState& state) {
+        mirror_pips.fill(0);
+        for (int idx = 0; idx < rows * cols; idx++) {
+            if (board_mask & cell_bit(idx)) mirror_pips[sym_cell_map[idx]] = state.cell_values[idx];
+        }
+        mirror_placed.clear();
+        for (const auto& p : state.placed) {
+            int a = sym_cell_map[index_of(p.cell1())], b = sym_cell_map[index_of(p.cell2())];
+            int first = min(a, b);
+            mirror_placed.push_back({p.domino, first / cols, first % cols, a / cols == b / cols,
+                                     mirror_pips[first] != p.domino.low});
+        }
+        mirror_key.assign(open_regions.size(), 0);
+        for (size_t j = 0; j < open_regions.size(); j++) {
+            int image = sym_region_map[open_regions[j]];
+            size_t k = find(open_regions.begin(), open_regions.end(), image) - open_regions.begin();
+            mirror_key[k] = sweep_key[j];
+        }
+    }
 
-            if (count == 1) {
-                lock_guard<mutex> lock(result_mutex);
-                if (!found_medium.load()) {
-                    found_medium = true;
-                    medium_result = PuzzleResult{
-                        dominoes, regions, rows, cols, "Medium_InequalityChain", solution
-                    };
-                    cout << "[Thread " << thread_id << "] Found Medium! Attempts: "
-                         << total_attempts.load() << endl;
-                    print_result("MEDIUM PUZZLE", medium_result);
-                    cout << flush;
+    // FNV-1a over the board's pips
+    uint64_t hash_pips(const array<uint8_t, MAX_CELLS>& pips) const {
+        uint64_t h = 14695981039346656037ull;
+        for (int i = 0; i < rows * cols; i++) {
+            h = (h ^ pips[i]) * 1099511628211ull;
+        }
+        return h;
+    }
+
+    // FNV-1a over a tuple of sums
+    static size_t hash_key(const vector<int>& key) {
+        uint64_t h = 14695981039346656037ull;
+        for (int v : key) h = (h ^ (uint32_t)v) * 1099511628211ull;
+        return (size_t)h;
+    }
+
+    // Kept at most half full, so linear probing stays short
+    void grow_sweep_index() {
+        sweep_index.assign(max<size_t>(64, sweep_index.size() * 2), -1);
+        size_t mask = sweep_index.size() - 1;
+        for (size_t e = 0; e < sweep_used; e++) {
+            size_t slot = hash_key(sweep_entries[e].targets) & mask;
+            while (sweep_index[slot] >= 0) slot = (slot + 1) & mask;
+            sweep_index[slot] = (int)e;
+        }
+    }
+
+    // Only the first filling per tuple is kept, so a later filling is a
+    // second solution exactly when its pips differ from the stored one
+    void record_sweep(const vector<int>& key, const array<uint8_t, MAX_CELLS>& pips,
+                      const vector<PlacedDomino>& placed) {
+        if (sweep_used * 2 >= sweep_index.size()) grow_sweep_index();
+        size_t mask = sweep_index.size() - 1;
+        size_t slot = hash_key(key) & mask;
+        for (; sweep_index[slot] >= 0; slot = (slot + 1) & mask) {
+            SweepEntry& entry = sweep_entries[sweep_index[slot]];
+            if (entry.targets != key) continue;
+            if (entry.count == 1 && entry.signature != pips) entry.count = 2;
+            return;
+        }
+        if (sweep_used == sweep_entries.size()) sweep_entries.emplace_back();
+        SweepEntry& entry = sweep_entries[sweep_used];
+        entry.targets = key;
+        entry.count = 1;
+        entry.signature = pips;
+        entry.solution = placed;
+        sweep_index[slot] = (int)sweep_used++;
+    }
+
+    // This solve's sweep entries in ascending order of their tuples; valid
+    // until the next solve
+    const vector<const SweepEntry*>& sweep_results() {
+        sweep_sorted.clear();
+        for (size_t e = 0; e < sweep_used; e++) sweep_sorted.push_back(&sweep_entries[e]);
+        sort(sweep_sorted.begin(), sweep_sorted.end(),
+             [](const SweepEntry* a, const SweepEntry* b) { return a->targets < b->targets; });
+        return sweep_sorted;
+    }
+
+    bool done() const {
+        int found = shared ? shared->count.load(memory_order_relaxed) : solution_count;
+        return !sweep && found >= max_solutions;
+    }
+
+    void reset() {
+        solution_count = 0;
+        first_solution.clear();
+        seen_hashes.clear();
+        if (sweep_used > 0) fill(sweep_index.begin(), sweep_index.end(), -1);
+        sweep_used = 0;
+    }
+
+    // The scratch state, reset for a solve with its buffers kept
+    SolverState& initial_state() {
+        vector<PlacedDomino> placed = move(scratch.placed);
+        vector<RegionTally> tally = move(scratch.region_tally);
+        SolverState& state = scratch = SolverState();
+        state.placed = move(placed);
+        state.placed.clear();
+        state.placed.reserve(dominoes.size());
+        state.region_tally = move(tally);
+        state.region_tally.assign(regions.size(), {});
+        for (const auto& d : dominoes) {
+            state.supply[d.low]++;
+            state.supply[d.high]++;
+            state.supply_mask |= (1u << d.low) | (1u << d.high);
+            state.pair_count[d.low * 16 + d.high]++;
+            state.partners[d.low] |= 1u << d.high;
+            state.partners[d.high] |= 1u << d.low;
+        }
+        return state;
+    }
+
+    template <class S = GenericShape>
+    int solve() {
+        reset();
+        transpose = !sweep && max_solutions <= 2 && !keep_second;
+        if (transpose) puzzle_key = fingerprint();
+        SolverState& state = initial_state();
+        backtrack<S>(state, 0);
+        stats = state.stats;
+        transpose = false;
+        return solution_count;
+    }
+
+    // Place a frontier node's dominoes on a fresh state. The prefix is
+    // never taken back, so the order of its set_cell() calls only shows in
+    // which cells count as repeats (an EQUAL region it reaches holds one
+    // pip throughout). Equal dominoes are interchangeable, so each takes
+    // the first unused index of its kind.
+    template <class S = GenericShape>
+    void replay_prefix(SolverState& state, const vector<PlacedDomino>& prefix) const {
+        for (const auto& p : prefix) {
+            int a = p.row * stride<S>() + p.col;
+            set_cell(state, a, p.pip1());
+            set_cell(state, p.horizontal ? a + 1 : a + stride<S>(), p.pip2());
+            state.placed.push_back(p);
+            size_t d = 0;
+            while ((state.used_dominoes >> d & 1) || !(dominoes[d] == p.domino)) d++;
+            take_domino(state, d);
+        }
+    }
+
+    // solve() with the search tree split across pool. The tree is expanded
+    // a level at a time until it has MIN_TASKS_PER_WORKER nodes per worker,
+    // each kept as its placements in the order the serial search reaches
+    // it. The pool tasks replay them onto per-worker states and search on
+    // through this solver, whose tables they only read. Fillings are
+    // shared, so the second distinct one stops every task. Sweeps and
+    // solves keeping a second filling run serially. Waits for the tasks,
+    // so it must not be called from one of pool's workers.
+    template <class S = GenericShape>
+    int solve_parallel(ThreadPool& pool) {
+        if (sweep || keep_second) return solve<S>();
+        reset();
+        SharedSolutions solutions;
+        shared = &solutions;
+        const SolverState root = initial_state();
+
+        vector<vector<PlacedDomino>> nodes(1), children;
+        SolverState state;
+        frontier = &children;
+        for (split_depth = 1; split_depth <= dominoes.size(); split_depth++) {
+            children.clear();
+            for (const auto& prefix : nodes) {
+                state = root;
+                replay_prefix<S>(state, prefix);
+                backtrack<S>(state, 2 * prefix.size());
+                solutions.stats.add(state.stats);
+            }
+            swap(nodes, children);
+            if (nodes.empty() || nodes.size() >= MIN_TASKS_PER_WORKER * pool.size()) break;
+        }
+        frontier = nullptr;
+
+        // Highest first, so workers popping their newest task start from
+        // the nodes the serial search reaches first
+        vector<SolverState> states(pool.size(), root);
+        vector<ThreadPool::Task> tasks;
+        TaskGroup group;
+        group.add(nodes.size());
+        for (size_t i = nodes.size(); i-- > 0; ) {
+            tasks.push_back([this, &nodes, &states, &root, &solutions, &group, i](int worker) {
+                if (!done()) {
+                    SolverState& task = states[worker];
+                    task = root;
+                    task.task_rank = i;
+                    replay_prefix<S>(task, nodes[i]);
+                    backtrack<S>(task, 2 * nodes[i].size());
+                    lock_guard<mutex> lock(solutions.m);
+                    solutions.stats.add(task.stats);
+                }
+                group.done();
+            });
+        }
+        pool.submit_all(tasks);
+        group.wait();
+
+        shared = nullptr;
+        solution_count = solutions.count;
+        first_pips = solutions.first_pips;
+        first_solution = move(solutions.first_solution);
+        stats = solutions.stats;
+        return solution_count;
+    }
+
+    // Zobrist salt of the puzzle, so that entries carry over between
+    // solves only when the dominoes, board and constraints all match
+    uint64_t fingerprint() const {
+        uint64_t h = zobrist(Z_PUZZLE | (uint64_t)rows << 8 | cols);
+        auto mix = [&h](uint64_t v) { h = zobrist(h ^ v); };
+        for (const auto& d : dominoes) mix(d.low << 4 | d.high);
+        for (const auto& r : regions) {
+            mix((uint64_t)r.type << 32 | (uint32_t)r.target_value);
+            mix((uint64_t)(uint32_t)r.linked_region_id << 8 | r.cells.size());
+            for (Cell c : r.cells) mix(c.first << 8 | c.second);
+        }
+        return h;
+    }
+};
+
+// Exact-cover (Dancing Links) engine. Primary columns are the board cells
+// and the k domino slots; each row places domino slot d on an adjacent cell
+// pair in one orientation. The matrix depends only on the board shape and
+// k, so it is built once per layout and reused across domino sets and
+// targets; pips and region constraints are checked on each chosen row
+// through the Solver's state.
+class DlxMatrix {
+public:
+    DlxMatrix(const Solver& layout, int num_dominoes)
+        : rows(layout.rows), cols(layout.cols), board_mask(layout.board_mask),
+          num_dominoes(num_dominoes) {
+        vector<int> cell_column(rows * cols, -1);
+        int num_columns = 0;
+        for (int idx = 0; idx < rows * cols; idx++) {
+            if (board_mask & cell_bit(idx)) cell_column[idx] = num_columns++;
+        }
+        int first_domino_column = num_columns;
+        num_columns += num_dominoes;
+
+        // Node 0 is the root, nodes 1..num_columns the column headers
+        for (int c = 0; c <= num_columns; c++) {
+            add_node(c);
+            L[c] = c == 0 ? num_columns : c - 1;
+            R[c] = c == num_columns ? 0 : c + 1;
+        }
+        size.assign(num_columns + 1, 0);
+
+        for (int a = 0; a < rows * cols; a++) {
+            if (cell_column[a] < 0) continue;
+            for (int b : layout.adjacent[a]) {
+                if (b < 0) break;
+                if (b < a) continue;
+                for (int d = 0; d < num_dominoes; d++) {
+                    for (int o = 0; o < 2; o++) {
+                        add_row({cell_column[a] + 1, cell_column[b] + 1, first_domino_column + d + 1},
+                                {a, b, d, o});
+                    }
                 }
+            }
+        }
+    }
+
+    bool matches(const Solver& layout) const {
+        return layout.rows == rows && layout.cols == cols &&
+               layout.board_mask == board_mask && (int)layout.dominoes.size() == num_dominoes;
+    }
+
+    template <class S = GenericShape>
+    int solve(Solver& solver) {
+        solver.reset();
+        SolverState& state = solver.initial_state();
+        search<S>(solver, state);
+        solver.stats = state.stats;
+        return solver.solution_count;
+    }
+
+private:
+    struct RowInfo {
+        int a, b;   // Cells covered, a < b
+        int d;      // Domino index
+        int o;      // 0: low on a, 1: high on a
+    };
+
+    int rows, cols;
+    CellMask board_mask;
+    int num_dominoes;
+
+    vector<int> L, R, U, D, C, row_of;  // Per node
+    vector<int> size;                   // Per column
+    vector<RowInfo> row_info;
+
+    int add_node(int column) {
+        int n = L.size();
+        L.push_back(n); R.push_back(n); U.push_back(n); D.push_back(n);
+        C.push_back(column);
+        row_of.push_back(-1);
+        return n;
+    }
+
+    void add_row(array<int, 3> columns, RowInfo info) {
+        int first = -1;
+        for (int c : columns) {
+            int n = add_node(c);
+            row_of[n] = row_info.size();
+            U[n] = U[c]; D[n] = c;
+            D[U[c]] = n; U[c] = n;
+            size[c]++;
+            if (first < 0) {
+                first = n;
+            } else {
+                L[n] = L[first]; R[n] = first;
+                R[L[first]] = n; L[first] = n;
+            }
+        }
+        row_info.push_back(info);
+    }
+
+    void cover(int c) {
+        R[L[c]] = R[c]; L[R[c]] = L[c];
+        for (int i = D[c]; i != c; i = D[i]) {
+            for (int j = R[i]; j != i; j = R[j]) {
+                U[D[j]] = U[j]; D[U[j]] = D[j];
+                size[C[j]]--;
+            }
+        }
+    }
+
+    void uncover(int c) {
+        for (int i = U[c]; i != c; i = U[i]) {
+            for (int j = L[i]; j != i; j = L[j]) {
+                size[C[j]]++;
+                U[D[j]] = j; D[U[j]] = j;
+            }
+        }
+        R[L[c]] = c; L[R[c]] = c;
+    }
+
+    template <class S>
+    void search(Solver& solver, SolverState& state) {
+        if (solver.done()) return;
+
+        if (R[0] == 0) {
+            solver.record_solution(state);
+            return;
+        }
+
+        // Column with the fewest remaining rows
+        int best = R[0];
+        for (int c = R[best]; c != 0; c = R[c]) {
+            if (size[c] < size[best]) best = c;
+        }
+        if (size[best] == 0) {
+            state.stats.dead_ends++;
+            return;
+        }
+
+        cover(best);
+        bool placed_any = false;
+        for (int r = D[best]; r != best; r = D[r]) {
+            const RowInfo& info = row_info[row_of[r]];
+            const Domino& domino = solver.dominoes[info.d];
+            if (info.o == 1 && domino.low == domino.high) continue;
+
+            int pip_a = info.o == 0 ? domino.low : domino.high;
+            int pip_b = info.o == 0 ? domino.high : domino.low;
+            solver.place(state, info.a, info.b, pip_a, pip_b);
+
+            if (!solver.placement_ok<S>(state, info.a, info.b)) {
+                if (solver.instrument) solver.count_pruned(state, info.a, info.b);
+            } else {
+                placed_any = true;
+                int stride = solver.stride<S>();
+                bool horiz = (info.a / stride == info.b / stride);
+                state.placed.push_back({domino, info.a / stride, info.a % stride, horiz,
+                                        pip_a != domino.low});
+
+                for (int j = R[r]; j != r; j = R[j]) cover(C[j]);
+                search<S>(solver, state);
+                for (int j = L[r]; j != r; j = L[j]) uncover(C[j]);
+
+                state.placed.pop_back();
+            }
+            solver.unplace(state, info.a, info.b);
+
+            if (solver.done()) break;
+        }
+        if (!placed_any) state.stats.dead_ends++;
+        uncover(best);
+    }
+};
+
+// All domino tilings of a board shape, enumerated once and reused for
+// every domino set and target on that layout. Solving then only assigns
+// dominoes and orientations to the slots of each tiling, so the geometric
+// search is paid once per layout instead of once per attempt.
+class TilingCache {
+public:
+    using Slot = pair<int, int>;  // Dense cell indices, first < second
+
+    explicit TilingCache(const Solver& layout)
+        : rows(layout.rows), cols(layout.cols), board_mask(layout.board_mask) {
+        vector<Slot> current;
+        enumerate(layout, 0, current);
+    }
+
+    bool matches(const Solver& layout) const {
+        return layout.rows == rows && layout.cols == cols && layout.board_mask == board_mask;
+    }
+
+    size_t size() const { return tilings.size(); }
+
+    template <class S = GenericShape>
+    int solve(Solver& solver) const {
+        solver.reset();
+        SolverState& state = solver.initial_state();
+        for (const auto& tiling : tilings) {
+            if (tiling.size() != solver.dominoes.size()) continue;
+            assign<S>(solver, state, tiling, 0);
+            if (solver.done()) break;
+        }
+        solver.stats = state.stats;
+        return solver.solution_count;
+    }
+
+private:
+    int rows, cols;
+    CellMask board_mask;
+    vector<vector<Slot>> tilings;
+
+    // Cover the lowest empty cell with a domino reaching right or down
+    void enumerate(const Solver& layout, CellMask filled, vector<Slot>& current) {
+        CellMask empty = board_mask & ~filled;
+        if (empty == 0) {
+            tilings.push_back(current);
+            return;
+        }
+        int a = 0;
+        while (!(empty & cell_bit(a))) a++;
+        for (int b : layout.adjacent[a]) {
+            if (b < 0) break;
+            if (b < a || !(empty & cell_bit(b))) continue;
+            current.push_back({a, b});
+            enumerate(layout, filled | cell_bit(a) | cell_bit(b), current);
+            current.pop_back();
+        }
+    }
+
+    // Fill the tiling's slots, i of which are placed, taking next the slot
+    // with the fewest placement options; a slot with none ends the branch.
+    template <class S>
+    void assign(Solver& solver, SolverState& state, const vector<Slot>& tiling, size_t i) const {
+        if (i == tiling.size()) {
+            solver.record_solution(state);
+            return;
+        }
+        int a = -1, b = -1;
+        uint16_t dom_a = 0, dom_b = 0;
+        int min_options = INT_MAX;
+        Solver::DomainCache<S> domains(solver, state);
+        for (auto [sa, sb] : tiling) {
+            if (state.filled_cells & cell_bit(sa)) continue;
+            uint16_t da = domains.of_cell(sa), db = domains.of_cell(sb);
+            int options = solver.pair_options(state, da, db);
+            if (options == 0) {
+                state.stats.dead_ends++;
                 return;
             }
+            if (options < min_options) {
+                min_options = options;
+                a = sa; b = sb;
+                dom_a = da; dom_b = db;
+            }
+        }
+        int stride = solver.stride<S>();
+        bool horiz = (a / stride == b / stride);
+
+        bool placed_any = false;
+        for (size_t d = 0; d < solver.dominoes.size(); d++) {
+            if (state.used_dominoes & (1ull << d)) continue;
+            const Domino& domino = solver.dominoes[d];
+
+            int n_orient = (domino.low != domino.high) ? 2 : 1;
+            for (int o = 0; o < n_orient; o++) {
+                int pip_a = o == 0 ? domino.low : domino.high;
+                int pip_b = o == 0 ? domino.high : domino.low;
+                if (!(dom_a & (1u << pip_a)) || !(dom_b & (1u << pip_b))) continue;
+                solver.place(state, a, b, pip_a, pip_b);
+
+                if (!solver.placement_ok<S>(state, a, b)) {
+                    if (solver.instrument) solver.count_pruned(state, a, b);
+                } else {
+                    placed_any = true;
+                    state.placed.push_back({domino, a / stride, a % stride, horiz, pip_a != domino.low});
+                    solver.take_domino(state, d);
+
+                    assign<S>(solver, state, tiling, i + 1);
+
+                    solver.return_domino(state, d);
+                    state.placed.pop_back();
+                }
+                solver.unplace(state, a, b);
+
+                if (solver.done()) return;
+            }
         }
+        if (!placed_any) state.stats.dead_ends++;
     }
-}
+};
 
-void search_hard(int thread_id, const vector<Domino>& d9_remainder, const vector<Domino>& unused_d6) {
-    // 2x8 grid with 8 dominoes - simpler layout, faster to search
-    // Using 4 regions of 4 cells with inequality chain
-    int rows = 2, cols = 8;
+// Conflict-driven clause learning SAT solver behind the SAT engine: two
+// watched literals, VSIDS branching with phase saving, first-UIP learning
+// with clause minimization, Luby restarts and periodic halving of the
+// learned clauses. It is incremental: clauses may be added between
+// solve() calls, and what earlier calls learned is kept.
+class SatSolver {
+public:
+    using Lit = int;  // 2 * variable, plus 1 when negated
+    static Lit pos(int var) { return 2 * var; }
+
+    uint64_t decisions = 0, conflicts = 0;
+
+    int new_var() {
+        int var = assigns.size();
+        assigns.push_back(0);
+        polarity.push_back(1);  // False first: most variables are false in a model
+        seen.push_back(0);
+        level.push_back(0);
+        reason.push_back(-1);
+        activity.push_back(0);
+        heap_index.push_back(-1);
+        watches.emplace_back();
+        watches.emplace_back();
+        heap_insert(var);
+        return var;
+    }
 
-    // 4 regions of 4 cells each (like Medium's 3-region version)
-    vector<Cell> region0 = {{0,0}, {0,1}, {1,0}, {1,1}};
-    vector<Cell> region1 = {{0,2}, {0,3}, {1,2}, {1,3}};
-    vector<Cell> region2 = {{0,4}, {0,5}, {1,4}, {1,5}};
-    vector<Cell> region3 = {{0,6}, {0,7}, {1,6}, {1,7}};
+    // False once the clauses can no longer be satisfied
+    bool add_clause(vector<Lit> lits) {
+        if (unsat) return false;
+        backtrack(0);
+        sort(lits.begin(), lits.end());
+        size_t n = 0;
+        for (Lit l : lits) {
+            if (value(l) > 0 || (n > 0 && lits[n - 1] == (l ^ 1))) return true;
+            if (value(l) < 0 || (n > 0 && lits[n - 1] == l)) continue;
+            lits[n++] = l;
+        }
+        lits.resize(n);
+        if (n == 0) {
+            unsat = true;
+        } else if (n == 1) {
+            enqueue(lits[0], -1);
+            unsat = propagate() >= 0;
+        } else {
+            attach(move(lits), false);
+        }
+        return !unsat;
+    }
 
-    auto combos = get_combinations(d9_remainder, 8);
+    // True with a model in model_true() if the clauses are satisfiable
+    bool solve() {
+        if (unsat) return false;
+        if (max_learnts == 0) max_learnts = max(clauses.size() / 3.0, 2000.0);
+        for (int restart = 0;; restart++) {
+            int result = search(RESTART_UNIT * luby(restart));
+            if (result != 0) return result > 0;
+        }
+    }
 
-    for (size_t i = thread_id; i < combos.size(); i += 4) {
-        if (found_hard.load()) return;
+    bool model_true(Lit l) const { return model[l >> 1] != (l & 1); }
+
+private:
+    struct Clause {
+        vector<Lit> lits;   // While unit or conflicting, lits[0] is the implied literal
+        double activity;
+        bool learnt;
+        bool deleted = false;
+    };
+    struct Watcher {
+        int clause;
+        Lit blocker;        // Some other literal of the clause; true => skip it
+    };
+    static constexpr uint64_t RESTART_UNIT = 100;  // Conflicts per Luby unit
+    static constexpr double VAR_DECAY = 0.95, CLAUSE_DECAY = 0.999;
+
+    bool unsat = false;
+    vector<Clause> clauses;
+    vector<vector<Watcher>> watches;          // Per literal: clauses watching it
+    vector<int8_t> assigns;                   // Per variable: 1 true, -1 false, 0 open
+    vector<int8_t> polarity;                  // Per variable: 1 => last assigned false
+    vector<int8_t> seen;                      // Scratch for analyze()
+    vector<Lit> analyzed;
+    vector<int> level, reason;                // Per variable; reason -1 for decisions
+    vector<Lit> trail;
+    vector<int> trail_lim;                    // Trail size at each decision
+    size_t qhead = 0;
+    vector<double> activity;
+    double var_inc = 1, clause_inc = 1;
+    vector<int> heap, heap_index;             // Open variables by activity
+    vector<bool> model;
+    size_t num_learnts = 0;
+    double max_learnts = 0;
+
+    int8_t value(Lit l) const { return (l & 1) ? -assigns[l >> 1] : assigns[l >> 1]; }
+    int decision_level() const { return trail_lim.size(); }
+
+    void enqueue(Lit l, int from) {
+        int var = l >> 1;
+        assigns[var] = (l & 1) ? -1 : 1;
+        level[var] = decision_level();
+        reason[var] = from;
+        trail.push_back(l);
+    }
 
-        const auto& dominoes = combos[i];
-        int total = 0;
-        for (const auto& d : dominoes) total += d.pips();
-
-        // Inequality chain A < B < C < D with sum on D
-        for (int target3 = 1; target3 < total; target3++) {
-            if (found_hard.load()) return;
-            total_attempts++;
-
-            vector<Region> regions = {
-                {0, region0, ConstraintType::LESS, -1, 1},
-                {1, region1, ConstraintType::LESS, -1, 2},
-                {2, region2, ConstraintType::LESS, -1, 3},
-                {3, region3, ConstraintType::SUM, target3, -1}
-            };
+    int attach(vector<Lit> lits, bool learnt) {
+        int id = clauses.size();
+        watches[lits[0]].push_back({id, lits[1]});
+        watches[lits[1]].push_back({id, lits[0]});
+        clauses.push_back({move(lits), 0, learnt});
+        return id;
+    }
 
-            vector<PlacedDomino> solution;
-            int count = test_puzzle(dominoes, rows, cols, regions, &solution);
+    // Unit propagation over the trail; the conflicting clause, or -1
+    int propagate() {
+        while (qhead < trail.size()) {
+            Lit false_lit = trail[qhead++] ^ 1;
+            auto& ws = watches[false_lit];
+            size_t i = 0, j = 0;
+            while (i < ws.size()) {
+                Watcher w = ws[i++];
+                if (value(w.blocker) > 0) {
+                    ws[j++] = w;
+                    continue;
+                }
+                Clause& c = clauses[w.clause];
+                if (c.deleted) continue;
+                auto& lits = c.lits;
+                if (lits[0] == false_lit) swap(lits[0], lits[1]);
+                Lit first = lits[0];
+                if (first != w.blocker && value(first) > 0) {
+                    ws[j++] = {w.clause, first};
+                    continue;
+                }
+                bool moved = false;
+                for (size_t k = 2; k < lits.size() && !moved; k++) {
+                    if (value(lits[k]) >= 0) {
+                        swap(lits[1], lits[k]);
+                        watches[lits[1]].push_back({w.clause, first});
+                        moved = true;
+                    }
+                }
+                if (moved) continue;
+                ws[j++] = w;
+                if (value(first) < 0) {
+                    while (i < ws.size()) ws[j++] = ws[i++];
+                    ws.resize(j);
+                    qhead = trail.size();
+                    return w.clause;
+                }
+                enqueue(first, w.clause);
+            }
+            ws.resize(j);
+        }
+        return -1;
+    }
 
-            if (count == 1) {
-                lock_guard<mutex> lock(result_mutex);
-                if (!found_hard.load()) {
-                    found_hard = true;
-                    hard_result = PuzzleResult{
-                        dominoes, regions, rows, cols, "Hard_D9Remainder", solution
-                    };
-                    cout << "[Thread " << thread_id << "] Found Hard! Attempts: "
-                         << total_attempts.load() << endl;
-                    print_result("HARD PUZZLE", hard_result);
-                    cout << flush;
+    // CDCL until a model, a refutation (1 / -1) or budget conflicts (0)
+    int search(uint64_t budget) {
+        vector<Lit> learnt;
+        for (uint64_t local = 0;;) {
+            int confl = propagate();
+            if (confl >= 0) {
+                conflicts++;
+                local++;
+                if (decision_level() == 0) {
+                    unsat = true;
+                    return -1;
                 }
-                return;
+                backtrack(analyze(confl, learnt));
+                if (learnt.size() == 1) {
+                    enqueue(learnt[0], -1);
+                } else {
+                    int id = attach(learnt, true);
+                    bump_clause(id);
+                    num_learnts++;
+                    enqueue(learnt[0], id);
+                }
+                var_inc /= VAR_DECAY;
+                clause_inc /= CLAUSE_DECAY;
+                continue;
+            }
+            if (local >= budget) {
+                backtrack(0);
+                return 0;
             }
+            if (num_learnts >= max_learnts) reduce();
+
+            int next = -1;
+            while (!heap.empty() && next < 0) {
+                int var = heap_pop();
+                if (assigns[var] == 0) next = var;
+            }
+            if (next < 0) {
+                model.resize(assigns.size());
+                for (size_t v = 0; v < assigns.size(); v++) model[v] = assigns[v] > 0;
+                backtrack(0);
+                return 1;
+            }
+            decisions++;
+            trail_lim.push_back(trail.size());
+            enqueue(pos(next) + polarity[next], -1);
         }
     }
-}
 
-// Unicode box drawing characters
-const string BOX_TL = "┌";
-const string BOX_TR = "┐";
-const string BOX_BL = "└";
-const string BOX_BR = "┘";
-const string BOX_H = "─";
-const string BOX_V = "│";
-const string BOX_CROSS = "┼";
-const string BOX_T_DOWN = "┬";
-const string BOX_T_UP = "┴";
-const string BOX_T_RIGHT = "├";
-const string BOX_T_LEFT = "┤";
+    // First-UIP clause of a conflict into learnt, asserting literal first;
+    // returns the level to back up to
+    int analyze(int confl, vector<Lit>& learnt) {
+        learnt.assign(1, 0);
+        int path = 0;
+        Lit p = -1;
+        int index = trail.size() - 1;
+        do {
+            if (clauses[confl].learnt) bump_clause(confl);
+            const auto& lits = clauses[confl].lits;
+            for (size_t j = p < 0 ? 0 : 1; j < lits.size(); j++) {
+                int var = lits[j] >> 1;
+                if (seen[var] || level[var] == 0) continue;
+                bump_var(var);
+                seen[var] = 1;
+                if (level[var] >= decision_level()) path++;
+                else learnt.push_back(lits[j]);
+            }
+            while (!seen[trail[index--] >> 1]) {}
+            p = trail[index + 1];
+            confl = reason[p >> 1];
+            seen[p >> 1] = 0;
+            path--;
+        } while (path > 0);
+        learnt[0] = p ^ 1;
+
+        // Drop literals whose reason is made of literals already in the clause
+        analyzed = learnt;
+        size_t n = 1;
+        for (size_t i = 1; i < learnt.size(); i++) {
+            int r = reason[learnt[i] >> 1];
+            bool redundant = r >= 0;
+            for (size_t k = 1; redundant && k < clauses[r].lits.size(); k++) {
+                int var = clauses[r].lits[k] >> 1;
+                redundant = seen[var] || level[var] == 0;
+            }
+            if (!redundant) learnt[n++] = learnt[i];
+        }
+        learnt.resize(n);
+        for (Lit l : analyzed) seen[l >> 1] = 0;
 
-// Thick box drawing for region boundaries
-const string THICK_H = "━";
-const string THICK_V = "┃";
+        if (n == 1) return 0;
+        size_t max_i = 1;
+        for (size_t i = 2; i < n; i++) {
+            if (level[learnt[i] >> 1] > level[learnt[max_i] >> 1]) max_i = i;
+        }
+        swap(learnt[1], learnt[max_i]);
+        return level[learnt[1] >> 1];
+    }
 
-void draw_puzzle_grid(const PuzzleResult& result) {
-    int rows = result.rows;
-    int cols = result.cols;
+    void backtrack(int to) {
+        if (decision_level() <= to) return;
+        for (int i = trail.size() - 1; i >= trail_lim[to]; i--) {
+            int var = trail[i] >> 1;
+            polarity[var] = trail[i] & 1;
+            assigns[var] = 0;
+            reason[var] = -1;
+            if (heap_index[var] < 0) heap_insert(var);
+        }
+        trail.resize(trail_lim[to]);
+        trail_lim.resize(to);
+        qhead = trail.size();
+    }
 
-    // Build cell-to-region map
-    map<Cell, int> cell_region;
-    for (const auto& r : result.regions) {
-        for (const auto& c : r.cells) {
-            cell_region[c] = r.id;
+    // Delete the less active half of the learned clauses that are not
+    // binary or a reason, and the watchers of every deleted clause
+    void reduce() {
+        vector<int> candidates;
+        for (size_t id = 0; id < clauses.size(); id++) {
+            const Clause& c = clauses[id];
+            if (!c.learnt || c.deleted || c.lits.size() <= 2) continue;
+            Lit l = c.lits[0];
+            if (reason[l >> 1] == (int)id && value(l) > 0) continue;
+            candidates.push_back(id);
+        }
+        sort(candidates.begin(), candidates.end(),
+             [&](int a, int b) { return clauses[a].activity < clauses[b].activity; });
+        for (size_t i = 0; i < candidates.size() / 2; i++) {
+            Clause& c = clauses[candidates[i]];
+            c.deleted = true;
+            vector<Lit>().swap(c.lits);
+            num_learnts--;
+        }
+        for (auto& ws : watches) {
+            ws.erase(remove_if(ws.begin(), ws.end(),
+                               [&](const Watcher& w) { return clauses[w.clause].deleted; }),
+                     ws.end());
         }
+        max_learnts *= 1.1;
     }
 
-    // Build cell-to-pip map from solution
-    map<Cell, int> cell_pip;
-    for (const auto& p : result.solution) {
-        Cell c1 = p.cell1();
-        Cell c2 = p.cell2();
-        cell_pip[c1] = p.domino.low;
-        cell_pip[c2] = p.domino.high;
+    void bump_var(int var) {
+        if ((activity[var] += var_inc) > 1e100) {
+            for (auto& a : activity) a *= 1e-100;
+            var_inc *= 1e-100;
+        }
+        if (heap_index[var] >= 0) sift_up(heap_index[var]);
     }
 
-    // Region labels
-    map<int, string> region_label;
-    for (const auto& r : result.regions) {
-        if (r.type == ConstraintType::SUM) {
-            region_label[r.id] = to_string(r.target_value);
-        } else if (r.type == ConstraintType::LESS) {
-            region_label[r.id] = "<" + to_string(r.linked_region_id);
-        } else if (r.type == ConstraintType::EQUAL) {
-            region_label[r.id] = "=";
-        } else if (r.type == ConstraintType::GREATER) {
-            region_label[r.id] = ">" + to_string(r.linked_region_id);
+    void bump_clause(int id) {
+        if ((clauses[id].activity += clause_inc) > 1e20) {
+            for (auto& c : clauses) {
+                if (c.learnt) c.activity *= 1e-20;
+            }
+            clause_inc *= 1e-20;
         }
     }
 
-    // Draw grid
-    int cell_width = 5;
-    string h_line(cell_width, '-');
+    // 1, 1, 2, 1, 1, 2, 4, ...
+    static uint64_t luby(int i) {
+        uint64_t size = 1;
+        int seq = 0;
+        while (size < (uint64_t)i + 1) {
+            seq++;
+            size = 2 * size + 1;
+        }
+        uint64_t x = i;
+        while (size - 1 != x) {
+            size = (size - 1) >> 1;
+            seq--;
+            x %= size;
+        }
+        return 1ull << seq;
+    }
 
-    // Top border
-    cout << "  ";
-    for (int c = 0; c < cols; c++) {
-        cout << "+" << h_line;
+    // Binary max-heap on activity
+    void heap_insert(int var) {
+        heap_index[var] = heap.size();
+        heap.push_back(var);
+        sift_up(heap_index[var]);
     }
-    cout << "+" << endl;
 
-    for (int r = 0; r < rows; r++) {
-        // Cell content row
-        cout << "  ";
-        for (int c = 0; c < cols; c++) {
-            Cell cell = {r, c};
-            bool thick_left = (c == 0) ||
-                (cell_region.count({r, c-1}) && cell_region[{r, c-1}] != cell_region[cell]);
+    int heap_pop() {
+        int top = heap[0];
+        heap_index[top] = -1;
+        int last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            heap[0] = last;
+            heap_index[last] = 0;
+            sift_down(0);
+        }
+        return top;
+    }
 
-            cout << (thick_left ? "|" : "|");
+    void sift_up(int i) {
+        int var = heap[i];
+        while (i > 0 && activity[var] > activity[heap[(i - 1) / 2]]) {
+            heap[i] = heap[(i - 1) / 2];
+            heap_index[heap[i]] = i;
+            i = (i - 1) / 2;
+        }
+        heap[i] = var;
+        heap_index[var] = i;
+    }
 
-            // Show region label in top-left cell of region, pip value otherwise
-            bool show_label = true;
-            int rid = cell_region[cell];
-            for (const auto& cr : result.regions[rid].cells) {
-                if (cr.first < r || (cr.first == r && cr.second < c)) {
-                    show_label = false;
-                    break;
+    void sift_down(int i) {
+        int var = heap[i];
+        for (;;) {
+            size_t child = 2 * i + 1;
+            if (child >= heap.size()) break;
+            if (child + 1 < heap.size() && activity[heap[child + 1]] > activity[heap[child]]) child++;
+            if (activity[heap[child]] <= activity[var]) break;
+            heap[i] = heap[child];
+            heap_index[heap[i]] = i;
+            i = child;
+        }
+        heap[i] = var;
+        heap_index[var] = i;
+    }
+};
+
+// SAT engine: the puzzle as CNF, one variable per cell and pip value and
+// one per domino placement, for the embedded SatSolver. Every domino takes
+// exactly one placement, every cell exactly one placement and one pip,
+// and a placement fixes the pips of its two cells. Region sums are
+// totalizers in order encoding (literal v of a sum is true when the sum is
+// at least v), which makes targets, thresholds and links unit and binary
+// clauses. Each filling found is blocked by a clause over its pips and the
+// same solver asked again, so the uniqueness check keeps everything the
+// first solve learned. It does not walk the board cell by cell, so many
+// small threshold regions on a large irregular board cost it little.
+class SatEncoding {
+public:
+    explicit SatEncoding(const Solver& solver) : cols(solver.cols) {
+        top = SatSolver::pos(sat.new_var());
+        sat.add_clause({top});
+
+        uint16_t pips = 0;
+        for (const auto& d : solver.dominoes) pips |= (1u << d.low) | (1u << d.high);
+        int n = solver.rows * solver.cols;
+        pip_lit.assign(n, {});
+        for (int idx = 0; idx < n; idx++) {
+            pip_lit[idx].fill(-1);
+            if (!(solver.board_mask & cell_bit(idx))) continue;
+            vector<Lit> any;
+            for (int p = 0; p <= solver.max_pip; p++) {
+                if (pips & (1u << p)) any.push_back(pip_lit[idx][p] = fresh());
+            }
+            exactly_one(any);
+        }
+
+        vector<vector<Lit>> by_domino(solver.dominoes.size()), by_cell(n);
+        vector<array<vector<Lit>, 16>> by_cell_pip(n);
+        for (int a = 0; a < n; a++) {
+            if (!(solver.board_mask & cell_bit(a))) continue;
+            for (int b : solver.adjacent[a]) {
+                if (b < 0) break;
+                if (b < a) continue;
+                for (size_t d = 0; d < solver.dominoes.size(); d++) {
+                    const Domino& domino = solver.dominoes[d];
+                    for (int o = 0; o < (domino.low != domino.high ? 2 : 1); o++) {
+                        int pip_a = o ? domino.high : domino.low;
+                        int pip_b = o ? domino.low : domino.high;
+                        Lit x = fresh();
+                        placements.push_back({(int)d, a, b, pip_a, x});
+                        sat.add_clause({x ^ 1, pip_lit[a][pip_a]});
+                        sat.add_clause({x ^ 1, pip_lit[b][pip_b]});
+                        by_domino[d].push_back(x);
+                        by_cell[a].push_back(x);
+                        by_cell[b].push_back(x);
+                        by_cell_pip[a][pip_a].push_back(x);
+                        by_cell_pip[b][pip_b].push_back(x);
+                    }
                 }
             }
+        }
+        for (auto& lits : by_domino) exactly_one(lits);
+        for (int idx = 0; idx < n; idx++) {
+            if (!(solver.board_mask & cell_bit(idx))) continue;
+            exactly_one(by_cell[idx]);
+            for (int p = 0; p < 16; p++) {
+                if (pip_lit[idx][p] < 0) continue;
+                // A pip shows only under a placement putting it there
+                vector<Lit> clause = by_cell_pip[idx][p];
+                clause.push_back(pip_lit[idx][p] ^ 1);
+                sat.add_clause(move(clause));
+            }
+        }
 
-            string content;
-            if (show_label && region_label.count(rid)) {
+        sums.assign(solver.regions.size(), {});
+        for (size_t rix = 0; rix < solver.regions.size(); rix++) {
+            const Region& region = solver.regions[rix];
+            const auto& cells = solver.region_cells[rix];
+            int t = region.target_value;
+            int linked = solver.linked_region[rix];
+            switch (region.type) {
+                case ConstraintType::SUM:
+                    if (t == OPEN_TARGET) break;
+                    sat.add_clause({at_least(solver, rix, t)});
+                    sat.add_clause({at_least(solver, rix, t + 1) ^ 1});
+                    break;
+                case ConstraintType::EQUAL:
+                    for (size_t i = 1; i < cells.size(); i++) {
+                        for (int p = 0; p < 16; p++) {
+                            if (pip_lit[cells[0]][p] < 0) continue;
+                            sat.add_clause({pip_lit[cells[0]][p] ^ 1, pip_lit[cells[i]][p]});
+                        }
+                    }
+                    break;
+                case ConstraintType::UNEQUAL:
+                    for (size_t i = 0; i < cells.size(); i++) {
+                        for (size_t j = i + 1; j < cells.size(); j++) {
+                            for (int p = 0; p < 16; p++) {
+                                if (pip_lit[cells[i]][p] < 0) continue;
+                                sat.add_clause({pip_lit[cells[i]][p] ^ 1, pip_lit[cells[j]][p] ^ 1});
+                            }
+                        }
+                    }
+                    break;
+                case ConstraintType::LESS:
+                case ConstraintType::GREATER: {
+                    bool less = region.type == ConstraintType::LESS;
+                    if (linked < 0) {
+                        if (less) sat.add_clause({at_least(solver, rix, t) ^ 1});
+                        else sat.add_clause({at_least(solver, rix, t + 1)});
+                        break;
+                    }
+                    // sum(low) < sum(high): sum(low) >= v forces sum(high) >= v + 1
+                    int low = less ? rix : linked, high = less ? linked : rix;
+                    int bound = region_bound(solver, low);
+                    for (int v = 0; v <= bound; v++) {
+                        sat.add_clause({at_least(solver, low, v) ^ 1, at_least(solver, high, v + 1)});
+                    }
+                    break;
+                }
+                case ConstraintType::EMPTY:
+                    break;
+            }
+        }
+    }
+
+    int solve(Solver& solver) {
+        solver.reset();
+        while (sat.solve()) {
+            array<uint8_t, MAX_CELLS> pips{};
+            vector<Lit> block;
+            for (size_t idx = 0; idx < pip_lit.size(); idx++) {
+                for (int p = 0; p < 16; p++) {
+                    if (pip_lit[idx][p] >= 0 && sat.model_true(pip_lit[idx][p])) {
+                        pips[idx] = p;
+                        block.push_back(pip_lit[idx][p] ^ 1);
+                    }
+                }
+            }
+            if (solver.solution_count == 0) {
+                solver.first_pips = pips;
+                solver.first_solution = placed(solver);
+            } else if (solver.solution_count == 1 && solver.keep_second) {
+                solver.second_pips = pips;
+            }
+            solver.solution_count++;
+            if (solver.done() || !sat.add_clause(move(block))) break;
+        }
+        solver.stats = {};
+        solver.stats.nodes = sat.decisions;
+        solver.stats.dead_ends = sat.conflicts;
+        return solver.solution_count;
+    }
+
+private:
+    using Lit = SatSolver::Lit;
+    struct Placement {
+        int d, a, b;   // Domino index on cells a < b
+        int pip_a;     // Pip on a
+        Lit lit;
+    };
+
+    SatSolver sat;
+    int cols;
+    Lit top;                                  // Fixed true
+    vector<array<Lit, 16>> pip_lit;           // Per dense cell, -1 for pips no domino has
+    vector<Placement> placements;
+    vector<vector<Lit>> sums;                 // Per region index, built on first use
+
+    Lit fresh() { return SatSolver::pos(sat.new_var()); }
+
+    void exactly_one(const vector<Lit>& lits) {
+        sat.add_clause(lits);
+        if (lits.size() <= 6) {
+            for (size_t i = 0; i < lits.size(); i++) {
+                for (size_t j = i + 1; j < lits.size(); j++) sat.add_clause({lits[i] ^ 1, lits[j] ^ 1});
+            }
+            return;
+        }
+        // Sequential counter: s turns true at the first true literal
+        Lit s = fresh();
+        sat.add_clause({lits[0] ^ 1, s});
+        for (size_t i = 1; i < lits.size(); i++) {
+            sat.add_clause({s ^ 1, lits[i] ^ 1});
+            if (i + 1 == lits.size()) break;
+            Lit next = fresh();
+            sat.add_clause({lits[i] ^ 1, next});
+            sat.add_clause({s ^ 1, next});
+            s = next;
+        }
+    }
+
+    int region_bound(const Solver& solver, int rix) const {
+        return solver.region_size[rix] * solver.max_pip;
+    }
+
+    // Literal for "region rix sums to at least v"
+    Lit at_least(const Solver& solver, int rix, int v) {
+        if (v <= 0) return top;
+        if (v > region_bound(solver, rix)) return top ^ 1;
+        if (sums[rix].empty()) {
+            const auto& cells = solver.region_cells[rix];
+            sums[rix] = total(solver, cells, 0, cells.size());
+        }
+        return sums[rix][v];
+    }
+
+    // Order-encoded sum of cells[begin, end); entry v for v >= 1
+    vector<Lit> total(const Solver& solver, const vector<int>& cells, size_t begin, size_t end) {
+        if (end - begin == 1) {
+            vector<Lit> unary(solver.max_pip + 1, top);
+            for (int v = 1; v <= solver.max_pip; v++) unary[v] = fresh();
+            for (int p = 0; p < 16; p++) {
+                Lit pip = pip_lit[cells[begin]][p];
+                if (pip < 0) continue;
+                for (int v = 1; v <= solver.max_pip; v++) sat.add_clause({pip ^ 1, unary[v] ^ (v > p)});
+            }
+            return unary;
+        }
+        size_t mid = (begin + end) / 2;
+        vector<Lit> a = total(solver, cells, begin, mid), b = total(solver, cells, mid, end);
+        int m = a.size() - 1, k = b.size() - 1;
+        vector<Lit> c(m + k + 1, top);
+        for (int v = 1; v <= m + k; v++) c[v] = fresh();
+        for (int i = 0; i <= m; i++) {
+            for (int j = 0; j <= k; j++) {
+                // a >= i and b >= j give c >= i + j; a < i + 1 and b < j + 1 give c < i + j + 1
+                if (i + j > 0) sat.add_clause({a[i] ^ 1, b[j] ^ 1, c[i + j]});
+                if (i + j < m + k) {
+                    sat.add_clause({i < m ? a[i + 1] : top ^ 1, j < k ? b[j + 1] : top ^ 1, c[i + j + 1] ^ 1});
+                }
+            }
+        }
+        return c;
+    }
+
+    vector<PlacedDomino> placed(const Solver& solver) const {
+        vector<PlacedDomino> out;
+        for (const auto& p : placements) {
+            if (!sat.model_true(p.lit)) continue;
+            const Domino& domino = solver.dominoes[p.d];
+            out.push_back({domino, p.a / cols, p.a % cols, p.a / cols == p.b / cols, p.pip_a != domino.low});
+        }
+        sort(out.begin(), out.end(), [](const PlacedDomino& x, const PlacedDomino& y) {
+            return make_pair(x.row, x.col) < make_pair(y.row, y.col);
+        });
+        return out;
+    }
+};
+
+// Solving engines selectable from test_puzzle(). AUTO takes the SAT
+// engine for boards of at least SAT_MIN_DOMINOES dominoes and the tiling
+// cache for smaller ones.
+enum class Engine { BACKTRACK, DLX, TILINGS, SAT, AUTO };
+constexpr size_t SAT_MIN_DOMINOES = 16;
+
+// The search layouts are small and reused across many attempts, so AUTO
+// gives them the tiling cache
+Engine search_engine = Engine::AUTO;
+
+string engine_name(Engine engine) {
+    switch (engine) {
+        case Engine::BACKTRACK: return "backtrack";
+        case Engine::DLX: return "dlx";
+        case Engine::TILINGS: return "tilings";
+        case Engine::SAT: return "sat";
+        case Engine::AUTO: return "auto";
+    }
+    return "unknown";
+}
+
+// Solve with a thread-local DLX matrix, rebuilt only when the layout changes
+template <class S = GenericShape>
+int solve_dlx(Solver& solver) {
+    thread_local unique_ptr<DlxMatrix> matrix;
+    if (!matrix || !matrix->matches(solver)) {
+        matrix = make_unique<DlxMatrix>(solver, solver.dominoes.size());
+    }
+    return matrix->solve<S>(solver);
+}
+
+// Solve over the thread-local tiling cache, rebuilt only when the layout changes
+template <class S = GenericShape>
+int solve_tilings(Solver& solver) {
+    thread_local unique_ptr<TilingCache> cache;
+    if (!cache || !cache->matches(solver)) {
+        cache = make_unique<TilingCache>(solver);
+    }
+    return cache->solve<S>(solver);
+}
+
+// Call f with the first specialized shape that fits the solver, or with
+// GenericShape. The specializations cover the search layouts (easy 2x4
+// and medium 3x4 on the double-six set, hard 2x8 on the double-nine pool)
+// and double-six puzzles of any size, which includes the NYT ones.
+template <class F>
+int with_shape(const Solver& solver, F f) {
+    if (solver.fits<Shape<2, 4, 6>>()) return f(Shape<2, 4, 6>{});
+    if (solver.fits<Shape<3, 4, 6>>()) return f(Shape<3, 4, 6>{});
+    if (solver.fits<Shape<2, 8, 9>>()) return f(Shape<2, 8, 9>{});
+    if (solver.fits<Shape<0, 0, 6>>()) return f(Shape<0, 0, 6>{});
+    return f(GenericShape{});
+}
+
+int solve_with(Solver& solver, Engine engine) {
+    if (engine == Engine::AUTO) {
+        engine = solver.dominoes.size() >= SAT_MIN_DOMINOES ? Engine::SAT : Engine::TILINGS;
+    }
+    // Sweeps tally every filling by its sums, which the SAT engine does not
+    // enumerate, so they stay with backtracking
+    if (engine == Engine::SAT && solver.sweep) engine = Engine::BACKTRACK;
+    if (engine == Engine::SAT) {
+        int count = SatEncoding(solver).solve(solver);
+        if (telemetry.enabled) telemetry.add(solver.stats);
+        return count;
+    }
+    int count = with_shape(solver, [&](auto shape) {
+        using S = decltype(shape);
+        return engine == Engine::DLX     ? solve_dlx<S>(solver)
+             : engine == Engine::TILINGS ? solve_tilings<S>(solver)
+             : solver.solve<S>();
+    });
+    if (telemetry.enabled) telemetry.add(solver.stats);
+    return count;
+}
+
+// Backtracking with the search tree split across pool, for single large
+// solves; must not be called from one of pool's workers
+int solve_split(Solver& solver, ThreadPool& pool) {
+    int count = with_shape(solver, [&](auto shape) {
+        return solver.solve_parallel<decltype(shape)>(pool);
+    });
+    if (telemetry.enabled) telemetry.add(solver.stats);
+    return count;
+}
+
+// Outcome of a uniqueness check
+enum class Uniqueness { NO_SOLUTION = 0, UNIQUE = 1, MULTIPLE = 2 };
+
+// Stop at the second distinct solution. The solution is only copied out
+// when it is unique.
+Uniqueness check_uniqueness(const vector<Domino>& dominoes, int rows, int cols,
+                            const vector<Region>& regions,
+                            vector<PlacedDomino>* solution_out = nullptr,
+                            Engine engine = Engine::AUTO) {
+    Solver solver(dominoes, regions, rows, cols, 2);
+    int count = solve_with(solver, engine);
+    if (count == 1 && solution_out) {
+        *solution_out = move(solver.first_solution);
+    }
+    return (Uniqueness)min(count, 2);
+}
+
+// Test a puzzle configuration: returns 0, 1 or 2 (two or more solutions)
+int test_puzzle(const vector<Domino>& dominoes, int rows, int cols,
+                const vector<Region>& regions, vector<PlacedDomino>* solution_out = nullptr,
+                Engine engine = Engine::AUTO) {
+    return (int)check_uniqueness(dominoes, rows, cols, regions, solution_out, engine);
+}
+
+// Solve once with every OPEN_TARGET SUM region unconstrained. The result
+// maps each tuple of sums those regions can take (in region order) to the
+// number of distinct fillings giving it, capped at 2, so every uniquely
+// solvable target assignment comes out of a single search.
+map<vector<int>, SweepEntry> sweep_targets(const vector<Domino>& dominoes, int rows, int cols,
+                                           const vector<Region>& regions,
+                                           Engine engine = Engine::BACKTRACK) {
+    Solver solver(dominoes, regions, rows, cols);
+    solver.sweep = true;
+    solve_with(solver, engine);
+    map<vector<int>, SweepEntry> results;
+    for (const SweepEntry* entry : solver.sweep_results()) results.emplace(entry->targets, *entry);
+    return results;
+}
+
+// The thread's solver for the search loops, loaded with each attempt in turn
+Solver& local_solver(const CompiledLayout& layout, const vector<Domino>& dominoes,
+                     const vector<Region>& regions) {
+    thread_local Solver solver;
+    solver.load(layout, dominoes, regions);
+    return solver;
+}
+
+// test_puzzle() on a compiled layout, through the thread's solver;
+// regions are the layout's with this attempt's targets
+int test_puzzle(const CompiledLayout& layout, const vector<Domino>& dominoes,
+                const vector<Region>& regions, vector<PlacedDomino>* solution_out = nullptr,
+                Engine engine = Engine::AUTO) {
+    Solver& solver = local_solver(layout, dominoes, regions);
+    int count = min(solve_with(solver, engine), 2);
+    if (count == 1 && solution_out) *solution_out = solver.first_solution;
+    return count;
+}
+
+// sweep_targets() on a compiled layout, through the thread's solver. The
+// entries come in ascending order of their tuples and live in the
+// solver's reused buffers, valid until the thread's next solve.
+const vector<const SweepEntry*>& sweep_targets(const CompiledLayout& layout,
+                                               const vector<Domino>& dominoes,
+                                               Engine engine = Engine::BACKTRACK) {
+    Solver& solver = local_solver(layout, dominoes, layout.regions);
+    solver.sweep = true;
+    solve_with(solver, engine);
+    return solver.sweep_results();
+}
+
+// Necessary conditions checked in O(n) before a puzzle reaches a solver.
+// Each region's sum is bounded by the smallest and largest pips it could
+// hold from the domino multiset; LESS/GREATER links then tighten the
+// bounds along each chain, and since the regions share the pips their
+// bounds must bracket the domino total.
+Rejection prefilter(const vector<Domino>& dominoes, const vector<Region>& regions) {
+    vector<int> pips;
+    for (const auto& d : dominoes) {
+        pips.push_back(d.low);
+        pips.push_back(d.high);
+    }
+    sort(pips.begin(), pips.end());
+    int n = pips.size();
+    vector<int> prefix(n + 1, 0);
+    for (int i = 0; i < n; i++) prefix[i + 1] = prefix[i] + pips[i];
+    int total = prefix[n];
+
+    int cells = 0;
+    for (const auto& r : regions) cells += r.cells.size();
+    if (cells > n) return Rejection::NONE;  // Leave malformed boards to the solver
+
+    int max_id = 0;
+    for (const auto& r : regions) max_id = max(max_id, r.id);
+    vector<int> region_by_id(max_id + 1, -1);
+    for (size_t i = 0; i < regions.size(); i++) region_by_id[regions[i].id] = i;
+
+    vector<int> lo(regions.size()), hi(regions.size());
+    vector<pair<int, int>> less_than;  // (a, b): sum of a < sum of b
+    for (size_t i = 0; i < regions.size(); i++) {
+        const Region& r = regions[i];
+        int s = r.cells.size();
+        lo[i] = prefix[s];
+        hi[i] = total - prefix[n - s];
+        if (r.type == ConstraintType::SUM && r.target_value != OPEN_TARGET) {
+            if (r.target_value < lo[i] || r.target_value > hi[i]) return Rejection::SUM_RANGE;
+            lo[i] = hi[i] = r.target_value;
+        } else if (r.type == ConstraintType::EQUAL) {
+            // Needs some pip value at least s times
+            int min_v = INT_MAX, max_v = -1;
+            for (int j = 0; j + s <= n; j++) {
+                if (pips[j] == pips[j + s - 1]) {
+                    min_v = min(min_v, pips[j]);
+                    max_v = max(max_v, pips[j]);
+                }
+            }
+            if (max_v < 0) return Rejection::PIP_MULTISET;
+            lo[i] = s * min_v;
+            hi[i] = s * max_v;
+        } else if (r.type == ConstraintType::UNEQUAL) {
+            // Needs s distinct pip values
+            vector<int> values = pips;
+            values.erase(unique(values.begin(), values.end()), values.end());
+            if ((int)values.size() < s) return Rejection::PIP_MULTISET;
+            lo[i] = accumulate(values.begin(), values.begin() + s, 0);
+            hi[i] = accumulate(values.end() - s, values.end(), 0);
+        } else if (r.linked_region_id < 0 &&
+                   (r.type == ConstraintType::LESS || r.type == ConstraintType::GREATER)) {
+            if (r.type == ConstraintType::LESS) hi[i] = min(hi[i], r.target_value - 1);
+            else lo[i] = max(lo[i], r.target_value + 1);
+            if (lo[i] > hi[i]) return Rejection::SUM_RANGE;
+        } else if (r.type == ConstraintType::LESS || r.type == ConstraintType::GREATER) {
+            int linked = region_by_id[r.linked_region_id];
+            if (r.type == ConstraintType::LESS) less_than.push_back({(int)i, linked});
+            else less_than.push_back({linked, (int)i});
+        }
+    }
+
+    // Bounds propagation; still changing after one round per region means
+    // the links contain a cycle, which no filling can satisfy
+    bool changed = true;
+    for (size_t round = 0; changed && round <= regions.size(); round++) {
+        changed = false;
+        for (auto [a, b] : less_than) {
+            if (lo[b] < lo[a] + 1) { lo[b] = lo[a] + 1; changed = true; }
+            if (hi[a] > hi[b] - 1) { hi[a] = hi[b] - 1; changed = true; }
+        }
+    }
+    if (changed) return Rejection::ORDERING;
+    int lo_total = 0, hi_total = 0;
+    for (size_t i = 0; i < regions.size(); i++) {
+        if (lo[i] > hi[i]) return Rejection::ORDERING;
+        lo_total += lo[i];
+        hi_total += hi[i];
+    }
+    if (cells == n && (total < lo_total || total > hi_total)) return Rejection::TOTAL;
+    return Rejection::NONE;
+}
+
+// prefilter() over up to LANES domino sets at once, for search loops that
+// test many sets against one layout. Per-lane values are kept in
+// struct-of-arrays form as GCC vector types one register wide, so every
+// step of the scalar pre-filter becomes a single vector operation over the
+// batch: 32 lanes with AVX-512, 16 with AVX2, 8 with SSE2 or NEON (and
+// plain loops where there is no vector unit). Lanes share the layout's
+// regions and domino count and differ in their dominoes and region
+// targets; each gets the verdict prefilter() would give it.
+class BatchPrefilter {
+public:
+#if defined(__AVX512BW__)
+    static constexpr int VECTOR_BYTES = 64;
+#elif defined(__AVX2__)
+    static constexpr int VECTOR_BYTES = 32;
+#else
+    static constexpr int VECTOR_BYTES = 16;
+#endif
+    static constexpr int LANES = VECTOR_BYTES / sizeof(int16_t);
+
+    BatchPrefilter(const vector<Region>& layout, int num_dominoes)
+        : regions(layout), num_pips(2 * num_dominoes), target(layout.size()),
+          lo(layout.size()), hi(layout.size()) {
+        int cells = 0;
+        for (const auto& r : regions) cells += r.cells.size();
+        oversized = cells > num_pips;
+        exact = cells == num_pips;
+
+        int max_id = 0;
+        for (const auto& r : regions) max_id = max(max_id, r.id);
+        vector<int> region_by_id(max_id + 1, -1);
+        for (size_t i = 0; i < regions.size(); i++) region_by_id[regions[i].id] = i;
+
+        // Links as (a, b) for sum of a < sum of b, in a topological order
+        // of the regions so one pass reaches prefilter()'s fixed point; a
+        // cycle fails every set, as the fixed point is never reached
+        vector<pair<int, int>> less_than;
+        vector<int> in_degree(regions.size(), 0);
+        for (size_t i = 0; i < regions.size(); i++) {
+            const Region& r = regions[i];
+            bool compared = r.type == ConstraintType::LESS || r.type == ConstraintType::GREATER;
+            if (!compared || r.linked_region_id < 0) continue;
+            int linked = region_by_id[r.linked_region_id];
+            less_than.push_back(r.type == ConstraintType::LESS ? pair{(int)i, linked}
+                                                               : pair{linked, (int)i});
+            in_degree[less_than.back().second]++;
+        }
+        vector<int> order;
+        for (size_t i = 0; i < regions.size(); i++) {
+            if (in_degree[i] == 0) order.push_back(i);
+        }
+        for (size_t j = 0; j < order.size(); j++) {
+            for (auto [a, b] : less_than) {
+                if (a == order[j] && --in_degree[b] == 0) order.push_back(b);
+            }
+        }
+        cyclic = order.size() < regions.size();
+        for (int a : order) {
+            for (auto edge : less_than) {
+                if (edge.first == a) links.push_back(edge);
+            }
+        }
+        clear();
+    }
+
+    int size() const { return lanes; }
+    bool full() const { return lanes == LANES; }
+
+    void clear() {
+        lanes = 0;
+        count.fill(Lanes{});
+        for (auto& t : target) t = Lanes{};
+    }
+
+    // Queue a domino set with the target values of regions, which must be
+    // the layout's regions up to their targets
+    void add(const vector<Domino>& dominoes, const vector<Region>& regions) {
+        int lane = lanes++;
+        sets[lane] = dominoes;
+        for (const auto& d : dominoes) {
+            count[d.low][lane]++;
+            count[d.high][lane]++;
+        }
+        // Sums never exceed 128 * 15, so clamping keeps every comparison
+        // and leaves the bounds well inside int16_t
+        for (size_t i = 0; i < regions.size(); i++) {
+            target[i][lane] = clamp(regions[i].target_value, -4096, 4096);
+        }
+    }
+
+    const vector<Domino>& dominoes(int lane) const { return sets[lane]; }
+    int target_of(int lane, int rix) const { return target[rix][lane]; }
+    bool passed(int lane) const { return reason[lane] == (int)Rejection::NONE; }
+
+    // Check the queued sets and count each rejection
+    void run() {
+        reason = Lanes{};
+        if (!oversized) check();
+        for (int lane = 0; lane < lanes; lane++) {
+            if (reason[lane] != (int)Rejection::NONE) rejections[reason[lane]]++;
+        }
+    }
+
+private:
+    using Lanes = int16_t __attribute__((vector_size(VECTOR_BYTES)));
+
+    vector<Region> regions;
+    int num_pips;
+    bool oversized, exact, cyclic;
+    vector<pair<int, int>> links;       // Topologically ordered
+
+    int lanes = 0;
+    array<vector<Domino>, LANES> sets;
+    array<Lanes, 16> count;             // Pips of each value, by value
+    vector<Lanes> target;               // Per region index
+    vector<Lanes> lo, hi;               // Per region index
+    Lanes reason;                       // Rejection per lane
+
+    static Lanes splat(int v) { return Lanes{} + (int16_t)v; }
+
+    // Record reason r on the lanes in mask that have not failed yet, so
+    // each lane keeps the first check it fails, as in prefilter()
+    void fail(const Lanes& mask, Rejection r) {
+        reason = (mask & (reason == 0)) ? splat((int)r) : reason;
+    }
+
+    // Smallest or largest total of s pips, taking values in ascending or
+    // descending order; distinct takes each value at most once
+    void extreme_total(Lanes& total, int s, bool largest, bool distinct) const {
+        Lanes left = splat(s);
+        total = Lanes{};
+        for (int i = 0; i < 16; i++) {
+            int v = largest ? 15 - i : i;
+            Lanes take = distinct ? (count[v] > 0) & (left > 0) & 1
+                                  : (count[v] < left ? count[v] : left);
+            total += take * splat(v);
+            left -= take;
+        }
+    }
+
+    void check() {
+        Lanes total{};
+        for (int v = 0; v < 16; v++) total += count[v] * splat(v);
+
+        for (size_t i = 0; i < regions.size(); i++) {
+            const Region& r = regions[i];
+            int s = r.cells.size();
+            extreme_total(lo[i], s, false, false);
+            extreme_total(hi[i], s, true, false);
+            if (r.type == ConstraintType::SUM) {
+                Lanes fixed = target[i] != OPEN_TARGET;
+                fail(fixed & ((target[i] < lo[i]) | (target[i] > hi[i])), Rejection::SUM_RANGE);
+                lo[i] = fixed ? target[i] : lo[i];
+                hi[i] = fixed ? target[i] : hi[i];
+            } else if (r.type == ConstraintType::EQUAL) {
+                // Needs some pip value at least s times
+                Lanes found{}, min_v{}, max_v{};
+                for (int v = 0; v < 16; v++) {
+                    Lanes ok = count[v] >= splat(s);
+                    min_v = (ok & ~found) ? splat(v) : min_v;
+                    max_v = ok ? splat(v) : max_v;
+                    found |= ok;
+                }
+                fail(~found, Rejection::PIP_MULTISET);
+                lo[i] = min_v * splat(s);
+                hi[i] = max_v * splat(s);
+            } else if (r.type == ConstraintType::UNEQUAL) {
+                // Needs s distinct pip values
+                Lanes values{};
+                for (int v = 0; v < 16; v++) values -= count[v] > 0;
+                fail(values < splat(s), Rejection::PIP_MULTISET);
+                extreme_total(lo[i], s, false, true);
+                extreme_total(hi[i], s, true, true);
+            } else if (r.linked_region_id < 0 &&
+                       (r.type == ConstraintType::LESS || r.type == ConstraintType::GREATER)) {
+                if (r.type == ConstraintType::LESS) {
+                    Lanes bound = target[i] - 1;
+                    hi[i] = bound < hi[i] ? bound : hi[i];
+                } else {
+                    Lanes bound = target[i] + 1;
+                    lo[i] = bound > lo[i] ? bound : lo[i];
+                }
+                fail(lo[i] > hi[i], Rejection::SUM_RANGE);
+            }
+        }
+
+        if (cyclic) {
+            fail(Lanes{} - 1, Rejection::ORDERING);
+            return;
+        }
+        for (auto [a, b] : links) {
+            Lanes bound = lo[a] + 1;
+            lo[b] = bound > lo[b] ? bound : lo[b];
+        }
+        for (auto it = links.rbegin(); it != links.rend(); ++it) {
+            Lanes bound = hi[it->second] - 1;
+            hi[it->first] = bound < hi[it->first] ? bound : hi[it->first];
+        }
+        for (size_t i = 0; i < regions.size(); i++) fail(lo[i] > hi[i], Rejection::ORDERING);
+
+        // Only lanes still passing are summed; their bounds lie within the
+        // pip range, so the totals cannot overflow
+        Lanes lo_total{}, hi_total{}, passing = reason == 0;
+        for (size_t i = 0; i < regions.size(); i++) {
+            lo_total += lo[i] & passing;
+            hi_total += hi[i] & passing;
+        }
+        if (exact) fail((total < lo_total) | (total > hi_total), Rejection::TOTAL);
+    }
+};
+
+// Lazy k-combinations of a domino pool, addressable by rank in the
+// lexicographic order of pool indices. Nothing is materialized: workers
+// unrank the start of their range and step with next() from there, so
+// memory stays flat regardless of pool size.
+class CombinationSpace {
+public:
+    CombinationSpace(const vector<Domino>& p, int k_) : pool(p), n(p.size()), k(k_) {}
+
+    // Number of combinations, saturating at UINT64_MAX
+    uint64_t size() const { return binomial(n, k); }
+
+    // Dominoes per combination
+    int set_size() const { return k; }
+
+    // Index tuple of the combination with the given rank
+    void unrank(uint64_t rank, vector<int>& idx) const {
+        idx.resize(k);
+        int v = 0;
+        for (int j = 0; j < k; j++) {
+            while (true) {
+                uint64_t with_v = binomial(n - 1 - v, k - 1 - j);
+                if (rank < with_v) break;
+                rank -= with_v;
+                v++;
+            }
+            idx[j] = v++;
+        }
+    }
+
+    // Inverse of unrank()
+    uint64_t rank_of(const vector<int>& idx) const {
+        uint64_t rank = 0;
+        int v = 0;
+        for (int j = 0; j < k; j++) {
+            for (; v < idx[j]; v++) rank += binomial(n - 1 - v, k - 1 - j);
+            v++;
+        }
+        return rank;
+    }
+
+    // Advance idx to the next combination; false after the last one
+    bool next(vector<int>& idx) const {
+        int i = k - 1;
+        while (i >= 0 && idx[i] == n - k + i) i--;
+        if (i < 0) return false;
+        idx[i]++;
+        for (int j = i + 1; j < k; j++) idx[j] = idx[j - 1] + 1;
+        return true;
+    }
+
+    void materialize(const vector<int>& idx, vector<Domino>& out) const {
+        out.clear();
+        for (int i : idx) out.push_back(pool[i]);
+    }
+
+    // FNV-1a over a caller tag, k and the pool, identifying the space
+    // across runs
+    uint64_t fingerprint(const string& tag) const {
+        uint64_t h = 14695981039346656037ull;
+        auto mix = [&h](int v) { h = (h ^ (uint64_t)v) * 1099511628211ull; };
+        for (char c : tag) mix(c);
+        mix(k);
+        for (const auto& d : pool) {
+            mix(d.low);
+            mix(d.high);
+        }
+        return h;
+    }
+
+    static uint64_t binomial(int n, int k) {
+        if (k < 0 || k > n) return 0;
+        k = min(k, n - k);
+        unsigned __int128 r = 1;
+        for (int i = 0; i < k; i++) {
+            r = r * (n - i) / (i + 1);
+            if (r > UINT64_MAX) return UINT64_MAX;
+        }
+        return (uint64_t)r;
+    }
+
+private:
+    const vector<Domino>& pool;
+    int n, k;
+};
+
+// Collect-all output. Each worker appends records to its own buffer and
+// hands a full buffer to the kernel with one write() on an O_APPEND
+// descriptor, so records never interleave and the search path takes no
+// lock. JSONL lines use the NYT puzzle schema plus "name" (and "linked"
+// for region-to-region less/greater), so verify can read them back.
+// Binary records are a u16 byte count followed by u8 fields: rows, cols,
+// domino count, region count; per region type, target (i16), linked
+// region (i8), cell count and dense cell indices; per domino its cells
+// and the pips on them, in that order. While hold is set, workers keep
+// their records until commit(), so a checkpoint can pair the file's
+// length with the ranks whose records it holds.
+class ResultWriter {
+public:
+    enum class Format { JSONL, BINARY };
+
+    bool open(const string& path, Format fmt, int workers) {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        format = fmt;
+        buffers = vector<Buffer>(workers);
+        if (fd >= 0) bytes = lseek(fd, 0, SEEK_END);
+        return fd >= 0;
+    }
+
+    bool enabled() const { return fd >= 0; }
+
+    bool hold = false;
+
+    void add(int worker, const string& name, const vector<Region>& regions, int rows, int cols,
+             const vector<PlacedDomino>& solution) {
+        Buffer& buffer = buffers[worker];
+        if (format == Format::JSONL) append_json(buffer.data, name, regions, solution);
+        else append_binary(buffer.data, regions, rows, cols, solution);
+        buffer.records++;
+        if (!hold && buffer.data.size() >= FLUSH_BYTES) flush(buffer);
+    }
+
+    // Write out a worker's records
+    void commit(int worker) { flush(buffers[worker]); }
+
+    void flush_all() {
+        for (auto& buffer : buffers) flush(buffer);
+    }
+
+    // Bytes in the file, counting what this run has written out
+    uint64_t size() const { return bytes.load(); }
+
+    // Drop whatever a previous run wrote past length
+    void truncate(uint64_t length) {
+        if (fd < 0 || length >= bytes.load() || ftruncate(fd, length) != 0) return;
+        bytes = length;
+    }
+
+    uint64_t count() const {
+        uint64_t total = 0;
+        for (const auto& buffer : buffers) total += buffer.records;
+        return total;
+    }
+
+private:
+    struct alignas(64) Buffer {
+        string data;
+        uint64_t records = 0;
+    };
+
+    static constexpr size_t FLUSH_BYTES = 1 << 16;
+    int fd = -1;
+    Format format = Format::JSONL;
+    vector<Buffer> buffers;
+    atomic<uint64_t> bytes{0};
+
+    void flush(Buffer& buffer) {
+        size_t done = 0;
+        while (done < buffer.data.size()) {
+            ssize_t n = ::write(fd, buffer.data.data() + done, buffer.data.size() - done);
+            if (n <= 0) break;
+            done += n;
+        }
+        bytes += done;
+        buffer.data.clear();
+    }
+
+    static const char* type_name(ConstraintType type) {
+        switch (type) {
+            case ConstraintType::SUM: return "sum";
+            case ConstraintType::EQUAL: return "equals";
+            case ConstraintType::LESS: return "less";
+            case ConstraintType::GREATER: return "greater";
+            case ConstraintType::UNEQUAL: return "unequal";
+            case ConstraintType::EMPTY: return "empty";
+        }
+        return "empty";
+    }
+
+    static void append_json(string& out, const string& name, const vector<Region>& regions,
+                            const vector<PlacedDomino>& solution) {
+        auto cell = [&out](Cell c) {
+            out += '[' + to_string(c.first) + ',' + to_string(c.second) + ']';
+        };
+        out += "{\"name\":\"" + name + "\",\"dominoes\":[";
+        for (size_t i = 0; i < solution.size(); i++) {
+            if (i) out += ',';
+            out += '[' + to_string(solution[i].pip1()) + ',' + to_string(solution[i].pip2()) + ']';
+        }
+        out += "],\"regions\":[";
+        for (size_t i = 0; i < regions.size(); i++) {
+            const Region& r = regions[i];
+            if (i) out += ',';
+            out += "{\"indices\":[";
+            for (size_t j = 0; j < r.cells.size(); j++) {
+                if (j) out += ',';
+                cell(r.cells[j]);
+            }
+            out += "],\"type\":\"";
+            out += (r.type == ConstraintType::SUM && r.target_value == OPEN_TARGET)
+                   ? "empty" : type_name(r.type);
+            out += '"';
+            if (r.linked_region_id >= 0) out += ",\"linked\":" + to_string(r.linked_region_id);
+            else if (r.target_value != OPEN_TARGET) out += ",\"target\":" + to_string(r.target_value);
+            out += '}';
+        }
+        out += "],\"solution\":[";
+        for (size_t i = 0; i < solution.size(); i++) {
+            if (i) out += ',';
+            out += '[';
+            cell(solution[i].cell1());
+            out += ',';
+            cell(solution[i].cell2());
+            out += ']';
+        }
+        out += "]}\n";
+    }
+
+    static void append_binary(string& out, const vector<Region>& regions, int rows, int cols,
+                              const vector<PlacedDomino>& solution) {
+        size_t start = out.size();
+        out.append(2, '\0');
+        auto byte = [&out](int v) { out += (char)(uint8_t)v; };
+        auto dense = [&](Cell c) { byte(c.first * cols + c.second); };
+        byte(rows);
+        byte(cols);
+        byte(solution.size());
+        byte(regions.size());
+        for (const auto& r : regions) {
+            byte((int)r.type);
+            byte(r.target_value & 0xff);
+            byte((r.target_value >> 8) & 0xff);
+            byte(r.linked_region_id);
+            byte(r.cells.size());
+            for (Cell c : r.cells) dense(c);
+        }
+        for (const auto& p : solution) {
+            dense(p.cell1());
+            dense(p.cell2());
+            byte(p.pip1());
+            byte(p.pip2());
+        }
+        uint16_t length = out.size() - start - 2;
+        out[start] = (char)(length & 0xff);
+        out[start + 1] = (char)(length >> 8);
+    }
+};
+
+ResultWriter collector;
+
+// Progress of one resumable parallel_for: chunk i covers
+// [begins[i], ends[i]) and every rank below next[i] is done. found and
+// result are the search's hit, if it stops at one.
+struct PhaseProgress {
+    uint64_t key;
+    vector<uint64_t> begins, ends;
+    unique_ptr<atomic<uint64_t>[]> next;
+    Found* found;
+    optional<PuzzleResult>* result;
+};
+
+// Snapshot of the resumable searches, saved periodically to a small
+// binary file of u64 fields: magic, total_attempts, the collect file's
+// length (UINT64_MAX when not collecting), phase count, then per phase
+// its key, chunk count, (begin, next, end) per chunk and the rank of its
+// hit (UINT64_MAX for none) followed by the hit's puzzle. Finished phases
+// stay in the file, so a resumed run keeps their hits without searching
+// again. It is written to a temporary file and renamed so a crash never
+// leaves it torn.
+class Checkpoint {
+public:
+    string path = "puzzle_gen.ckpt";
+    bool enabled = false;
+
+    // Read a previous run's file; its phases resume if their keys recur,
+    // and collected records past the saved length are dropped since their
+    // ranks will be searched again
+    bool load() {
+        ifstream in(path, ios::binary);
+        uint64_t magic = 0, attempts = 0, collected = 0, phases = 0;
+        if (!read(in, magic) || magic != MAGIC || !read(in, attempts) || !read(in, collected) ||
+            !read(in, phases)) {
+            return false;
+        }
+        for (uint64_t p = 0; p < phases; p++) {
+            uint64_t key = 0, chunks = 0;
+            if (!read(in, key) || !read(in, chunks)) return false;
+            SavedPhase& phase = saved[key];
+            phase.ranges.resize(chunks);
+            for (auto& r : phase.ranges) {
+                if (!read(in, r[0]) || !read(in, r[1]) || !read(in, r[2])) return false;
+            }
+            if (!read(in, phase.hit_rank)) return false;
+            if (phase.hit_rank != UINT64_MAX) {
+                phase.hit.emplace();
+                if (!read_puzzle(in, *phase.hit)) return false;
+            }
+        }
+        total_attempts.store(attempts);
+        if (collected != UINT64_MAX) collector.truncate(collected);
+        return true;
+    }
+
+    void save() {
+        lock_guard<mutex> lock(m);
+        string tmp = path + ".tmp";
+        {
+            ofstream out(tmp, ios::binary | ios::trunc);
+            write(out, MAGIC);
+            write(out, total_attempts.load());
+            write(out, collector.enabled() ? collector.size() : UINT64_MAX);
+            write(out, (uint64_t)active.size());
+            for (const auto& phase : active) {
+                write(out, phase.key);
+                write(out, (uint64_t)phase.begins.size());
+                for (size_t i = 0; i < phase.begins.size(); i++) {
+                    write(out, phase.begins[i]);
+                    write(out, phase.next[i].load());
+                    write(out, phase.ends[i]);
+                }
+                // Results are claimed under console_mutex
+                lock_guard<mutex> hit_lock(console_mutex);
+                bool hit = phase.found && phase.result && *phase.result;
+                write(out, hit ? phase.found->rank.load() : UINT64_MAX);
+                if (hit) write_puzzle(out, **phase.result);
+            }
+            if (!out) return;
+        }
+        rename(tmp.c_str(), path.c_str());
+    }
+
+    // Chunks for a search over [begin, end): the saved ones if this phase
+    // was in the checkpoint, with its hit put back into found and result,
+    // else a fresh split
+    PhaseProgress* begin_phase(uint64_t key, uint64_t begin, uint64_t end, uint64_t chunk,
+                               Found* found, optional<PuzzleResult>* result) {
+        lock_guard<mutex> lock(m);
+        active.push_back({key, {}, {}, nullptr, found, result});
+        PhaseProgress& phase = active.back();
+        auto it = saved.find(key);
+        if (it != saved.end()) {
+            for (const auto& r : it->second.ranges) {
+                phase.begins.push_back(r[0]);
+                phase.ends.push_back(r[2]);
+            }
+            if (it->second.hit && found && result) {
+                found->rank = it->second.hit_rank;
+                *result = move(it->second.hit);
+            }
+        } else {
+            for (uint64_t b = begin; b < end; b += chunk) {
+                phase.begins.push_back(b);
+                phase.ends.push_back(b + min(chunk, end - b));
+            }
+        }
+        phase.next.reset(new atomic<uint64_t>[phase.begins.size()]);
+        for (size_t i = 0; i < phase.begins.size(); i++) {
+            phase.next[i] = it != saved.end() ? it->second.ranges[i][1] : phase.begins[i];
+        }
+        if (it != saved.end()) saved.erase(it);
+        return &phase;
+    }
+
+    // Record every rank below next as done in chunk c. A worker's held
+    // records are written out first, under the lock save() takes, so a
+    // saved file length never covers ranks the checkpoint would redo.
+    void advance(PhaseProgress* phase, size_t c, uint64_t next, int worker) {
+        lock_guard<mutex> lock(m);
+        if (collector.enabled()) collector.commit(worker);
+        phase->next[c] = next;
+    }
+
+private:
+    static constexpr uint64_t MAGIC = 0x32504b4353504950ull;  // "PIPSCKP2"
+
+    struct SavedPhase {
+        vector<array<uint64_t, 3>> ranges;
+        uint64_t hit_rank = UINT64_MAX;
+        optional<PuzzleResult> hit;
+    };
+
+    mutex m;
+    list<PhaseProgress> active;               // Stable addresses for workers
+    map<uint64_t, SavedPhase> saved;
+
+    static bool read(ifstream& in, uint64_t& v) {
+        return (bool)in.read(reinterpret_cast<char*>(&v), sizeof(v));
+    }
+    static void write(ofstream& out, uint64_t v) {
+        out.write(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+
+    // A puzzle as its name length and bytes, grid size, dominoes, regions
+    // and solution placements; signed fields are stored sign-extended
+    static void write_puzzle(ofstream& out, const PuzzleResult& r) {
+        write(out, r.name.size());
+        out.write(r.name.data(), r.name.size());
+        write(out, r.rows);
+        write(out, r.cols);
+        write(out, r.dominoes.size());
+        for (const auto& d : r.dominoes) {
+            write(out, d.low);
+            write(out, d.high);
+        }
+        write(out, r.regions.size());
+        for (const auto& region : r.regions) {
+            write(out, region.id);
+            write(out, (uint64_t)region.type);
+            write(out, region.target_value);
+            write(out, region.linked_region_id);
+            write(out, region.cells.size());
+            for (Cell c : region.cells) {
+                write(out, c.first);
+                write(out, c.second);
+            }
+        }
+        write(out, r.solution.size());
+        for (const auto& p : r.solution) {
+            write(out, p.domino.low);
+            write(out, p.domino.high);
+            write(out, p.row);
+            write(out, p.col);
+            write(out, p.horizontal);
+            write(out, p.flipped);
+        }
+    }
+
+    static bool read_puzzle(ifstream& in, PuzzleResult& r) {
+        uint64_t n = 0, a = 0, b = 0;
+        auto field = [&in](auto& v) {
+            uint64_t x = 0;
+            if (!read(in, x)) return false;
+            v = (remove_reference_t<decltype(v)>)(int64_t)x;
+            return true;
+        };
+        if (!read(in, n) || n > 256) return false;
+        r.name.resize(n);
+        if (!in.read(r.name.data(), n) || !field(r.rows) || !field(r.cols) || !read(in, n) ||
+            n > 64) {
+            return false;
+        }
+        r.dominoes.resize(n);
+        for (auto& d : r.dominoes) {
+            if (!field(d.low) || !field(d.high)) return false;
+        }
+        if (!read(in, n) || n > MAX_CELLS) return false;
+        r.regions.resize(n);
+        for (auto& region : r.regions) {
+            if (!field(region.id) || !read(in, a) || a >= NUM_CONSTRAINT_TYPES ||
+                !field(region.target_value) || !field(region.linked_region_id) || !read(in, b) ||
+                b > MAX_CELLS) {
+                return false;
+            }
+            region.type = (ConstraintType)a;
+            region.cells.resize(b);
+            for (auto& c : region.cells) {
+                if (!field(c.first) || !field(c.second)) return false;
+            }
+        }
+        if (!read(in, n) || n > 64) return false;
+        r.solution.resize(n);
+        for (auto& p : r.solution) {
+            if (!field(p.domino.low) || !field(p.domino.high) || !field(p.row) || !field(p.col) ||
+                !field(p.horizontal) || !field(p.flipped)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+Checkpoint checkpoint;
+
+// Daily mode searches every difficulty at once over its full pool,
+// gathering up to limit unique puzzles for each; pack_disjoint() then
+// picks one per difficulty so that no two share a domino
+enum class Difficulty { EASY1, EASY2, MEDIUM, HARD };
+constexpr int NUM_DIFFICULTIES = 4;
+
+class CandidatePool {
+public:
+    size_t limit = 0;   // Per difficulty; 0 when not gathering
+
+    bool enabled() const { return limit > 0; }
+
+    // Keep a candidate; false once the difficulty has reached its limit,
+    // which ends that search
+    bool add(Difficulty d, PuzzleResult result) {
+        lock_guard<mutex> lock(mutexes[(int)d]);
+        vector<PuzzleResult>& list = lists[(int)d];
+        if (list.size() < limit) list.push_back(move(result));
+        return list.size() < limit;
+    }
+
+    // By domino set, so packing does not depend on which worker found what first
+    array<vector<PuzzleResult>, NUM_DIFFICULTIES>& sorted() {
+        for (auto& list : lists) {
+            sort(list.begin(), list.end(), [](const PuzzleResult& a, const PuzzleResult& b) {
+                return a.dominoes < b.dominoes;
+            });
+        }
+        return lists;
+    }
+
+private:
+    array<mutex, NUM_DIFFICULTIES> mutexes;
+    array<vector<PuzzleResult>, NUM_DIFFICULTIES> lists;
+};
+
+CandidatePool candidates;
+
+// Set packing over the candidates: at most one per difficulty, no domino
+// used twice, as many difficulties covered as possible. Returns the index
+// chosen for each difficulty or -1; among the best packings the first in
+// candidate order wins.
+vector<int> pack_disjoint(const array<vector<PuzzleResult>, NUM_DIFFICULTIES>& lists) {
+    using DominoMask = bitset<256>;  // Bit low * 16 + high
+    vector<vector<DominoMask>> masks(NUM_DIFFICULTIES);
+    for (int d = 0; d < NUM_DIFFICULTIES; d++) {
+        for (const auto& result : lists[d]) {
+            DominoMask mask;
+            for (const auto& dom : result.dominoes) mask.set(dom.low * 16 + dom.high);
+            masks[d].push_back(mask);
+        }
+    }
+
+    vector<int> pick(NUM_DIFFICULTIES, -1), best(NUM_DIFFICULTIES, -1);
+    int best_count = 0;
+    auto search = [&](auto& self, int d, const DominoMask& used, int count) -> void {
+        if (d == NUM_DIFFICULTIES) {
+            if (count > best_count) {
+                best_count = count;
+                best = pick;
+            }
+            return;
+        }
+        if (count + (NUM_DIFFICULTIES - d) <= best_count) return;
+        for (size_t i = 0; i < masks[d].size() && best_count < NUM_DIFFICULTIES; i++) {
+            if ((used & masks[d][i]).any()) continue;
+            pick[d] = i;
+            self(self, d + 1, used | masks[d][i], count + 1);
+        }
+        pick[d] = -1;
+        self(self, d + 1, used, count);
+    };
+    search(search, 0, DominoMask(), 0);
+    return best;
+}
+
+// Run body over [begin, end) in steps that start at one rank and double
+// while they finish within 10ms, calling after(begin, stop) after each.
+// after() returns where the ranks the step really searched end; a step
+// cut short ends the run.
+template <class After>
+void run_in_steps(const function<void(int, uint64_t, uint64_t)>& body, int worker,
+                  uint64_t begin, uint64_t end, After after) {
+    uint64_t step = 1;
+    while (begin < end) {
+        uint64_t stop = begin + min(step, end - begin);
+        auto t0 = chrono::steady_clock::now();
+        body(worker, begin, stop);
+        if (after(begin, stop) < stop) return;
+        if (chrono::steady_clock::now() - t0 < chrono::milliseconds(10)) step *= 2;
+        begin = stop;
+    }
+}
+
+// Split [0, n) into chunks, run body(worker_id, begin, end) for each on the
+// pool and block until all chunks finish. Chunks are small relative to the
+// thread count so stealing can even out combinations of very different cost.
+// With a nonzero checkpoint_key and checkpointing enabled, chunks run in
+// steps whose completion the checkpoint records, and a resumed run skips
+// the ranks already done; slow ranks are thus recorded one at a time.
+// With a label and telemetry enabled, chunks also run in steps and the
+// ranks done feed the progress ETA. A sharded run covers only this host's
+// share of [0, n), checkpointed under a key of its own so that resuming
+// cannot pick up another shard's progress. Chunks are submitted highest
+// first, so workers popping their newest task start from the lowest
+// ranks and a search can drop the rest soon after its first hit. A
+// search that stops at a hit passes its found and result, which the
+// checkpoint saves with its progress; ranks past the hit are skipped,
+// not searched, so they are not recorded as done.
+void parallel_for(ThreadPool& pool, uint64_t n,
+                  const function<void(int, uint64_t, uint64_t)>& body,
+                  uint64_t checkpoint_key = 0, const string& label = "",
+                  Found* found = nullptr, optional<PuzzleResult>* result = nullptr) {
+    uint64_t lo = shard.begin(n), hi = shard.end(n);
+    if (shard.enabled && checkpoint_key) {
+        checkpoint_key = (checkpoint_key ^ (shard.index << 32 | shard.count)) * 1099511628211ull;
+    }
+    uint64_t chunk = max<uint64_t>(1, (hi - lo) / (pool.size() * 64));
+    TaskGroup group;
+    vector<ThreadPool::Task> tasks;
+    Telemetry::Phase* progress = nullptr;
+    if (checkpoint_key && checkpoint.enabled) {
+        PhaseProgress* phase = checkpoint.begin_phase(checkpoint_key, lo, hi, chunk, found, result);
+        if (telemetry.enabled && !label.empty()) {
+            uint64_t done = 0;
+            for (size_t c = 0; c < phase->begins.size(); c++) {
+                done += phase->next[c] - phase->begins[c];
+            }
+            progress = telemetry.begin_phase(label, hi - lo, done);
+        }
+        for (size_t c = phase->begins.size(); c-- > 0; ) {
+            if (phase->next[c] >= phase->ends[c]) continue;
+            group.add();
+            tasks.push_back([&body, &group, phase, progress, found, c](int worker) {
+                run_in_steps(body, worker, phase->next[c], phase->ends[c],
+                             [phase, progress, found, c, worker](uint64_t begin, uint64_t stop) {
+                    uint64_t best = found ? found->rank.load() : UINT64_MAX;
+                    uint64_t searched = max(begin, best < stop ? best + 1 : stop);
+                    checkpoint.advance(phase, c, searched, worker);
+                    if (progress) progress->done += searched - begin;
+                    return searched;
+                });
+                group.done();
+            });
+        }
+        pool.submit_all(tasks);
+        group.wait();
+        if (progress) telemetry.end_phase(progress);
+        return;
+    }
+    if (telemetry.enabled && !label.empty()) progress = telemetry.begin_phase(label, hi - lo, 0);
+    for (uint64_t c = (hi - lo + chunk - 1) / chunk; c-- > 0; ) {
+        uint64_t begin = lo + c * chunk, end = min(begin + chunk, hi);
+        group.add();
+        tasks.push_back([&body, &group, progress, begin, end](int worker) {
+            if (progress) {
+                run_in_steps(body, worker, begin, end, [progress](uint64_t begin, uint64_t stop) {
+                    progress->done += stop - begin;
+                    return stop;
+                });
+            } else {
+                body(worker, begin, end);
+            }
+            group.done();
+        });
+    }
+    pool.submit_all(tasks);
+    group.wait();
+    if (progress) telemetry.end_phase(progress);
+}
+
+// Runs several searches on one pool at once. Each worker repeatedly takes
+// a step of the search with the fewest workers on it, ties going to the
+// one that has had the least worker time, so a search whose ranks cost
+// seconds cannot crowd out ones whose ranks cost microseconds. Steps start
+// at one rank and double while they finish within 10ms. A search ends when
+// its ranks (this host's share of them in a sharded run) run out or its
+// stop flag is set.
+class JointScheduler {
+public:
+    void add(const string& label, uint64_t n, function<void(int, uint64_t, uint64_t)> body,
+             const atomic<bool>& stop) {
+        Search& s = searches.emplace_back(Search{label, shard.end(n), move(body), &stop});
+        s.next = shard.begin(n);
+    }
+
+    void run(ThreadPool& pool) {
+        for (auto& s : searches) {
+            if (telemetry.enabled) s.progress = telemetry.begin_phase(s.label, s.end - s.next, 0);
+        }
+        TaskGroup group;
+        group.add(pool.size());
+        for (int i = 0; i < pool.size(); i++) {
+            pool.submit([this, &group](int worker) {
+                work(worker);
+                group.done();
+            });
+        }
+        group.wait();
+        for (auto& s : searches) {
+            if (s.progress) telemetry.end_phase(s.progress);
+        }
+    }
+
+private:
+    struct Search {
+        string label;
+        uint64_t end;                 // Ranks [next, end) are left
+        function<void(int, uint64_t, uint64_t)> body;
+        const atomic<bool>* stop;
+        uint64_t next = 0, step = 1;
+        uint64_t used_ns = 0;
+        int running = 0;
+        Telemetry::Phase* progress = nullptr;
+    };
+
+    mutex m;                  // Guards the scheduling fields of searches
+    vector<Search> searches;
+
+    void work(int worker) {
+        while (true) {
+            Search* s = nullptr;
+            uint64_t begin, end;
+            {
+                lock_guard<mutex> lock(m);
+                for (auto& c : searches) {
+                    if (c.next >= c.end || c.stop->load()) continue;
+                    if (!s || c.running < s->running ||
+                        (c.running == s->running && c.used_ns < s->used_ns)) s = &c;
+                }
+                if (!s) return;
+                begin = s->next;
+                end = begin + min(s->step, s->end - begin);
+                s->next = end;
+                s->running++;
+            }
+
+            auto t0 = chrono::steady_clock::now();
+            s->body(worker, begin, end);
+            auto elapsed = chrono::steady_clock::now() - t0;
+            if (s->progress) s->progress->done += end - begin;
+
+            lock_guard<mutex> lock(m);
+            s->running--;
+            s->used_ns += chrono::duration_cast<chrono::nanoseconds>(elapsed).count();
+            if (elapsed < chrono::milliseconds(10)) s->step *= 2;
+        }
+    }
+};
+
+// xoshiro256** seeded through splitmix64. Seeding with (seed, stream)
+// gives every sample its own sequence, so what a run finds does not
+// depend on how samples are spread over threads.
+class Rng {
+public:
+    Rng(uint64_t seed, uint64_t stream = 0) {
+        uint64_t x = seed ^ (stream * 0xd1342543de82ef95ull);
+        for (auto& w : s) w = splitmix(x);
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Uniform in [0, n)
+    uint32_t below(uint32_t n) { return (uint32_t)(((next() >> 32) * n) >> 32); }
+    bool chance(double p) { return (next() >> 11) * 0x1.0p-53 < p; }
+
+private:
+    uint64_t s[4];
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+    static uint64_t splitmix(uint64_t& x) {
+        uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+};
+
+// Sample an NYT-style puzzle: a connected board grown one domino at a time
+// inside a box x box square (so it always has a tiling), dominoes drawn
+// from pool and planted on that tiling, and the board cut into regions of
+// 1-4 cells whose constraints hold for the planted pips. The puzzle thus
+// has at least one solution; false if the board could not be grown.
+bool random_puzzle(Rng& rng, const vector<Domino>& pool, int num_dominoes, int box,
+                   vector<Domino>& dominoes, vector<Region>& regions, int& rows, int& cols) {
+    const int dr[4] = {-1, 1, 0, 0}, dc[4] = {0, 0, -1, 1};
+    vector<int> pip(box * box, -1);
+    vector<pair<int, int>> candidates;       // Free domino slots (a, b)
+    vector<int> frontier;                     // Free cells next to a growing region
+
+    // Partial Fisher-Yates for the domino sample
+    vector<int> order(pool.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    dominoes.clear();
+    for (int i = 0; i < num_dominoes; i++) {
+        swap(order[i], order[i + rng.below(order.size() - i)]);
+        dominoes.push_back(pool[order[i]]);
+    }
+
+    for (int d = 0; d < num_dominoes; d++) {
+        int a, b;
+        if (d == 0) {
+            a = (box / 2) * box + box / 2;
+            b = rng.chance(0.5) ? a + 1 : a + box;
+        } else {
+            // Any free domino slot touching the board
+            candidates.clear();
+            for (int idx = 0; idx < box * box; idx++) {
+                if (pip[idx] >= 0) continue;
+                int r = idx / box, c = idx % box;
+                bool touches = false;
+                for (int k = 0; k < 4 && !touches; k++) {
+                    int nr = r + dr[k], nc = c + dc[k];
+                    touches = nr >= 0 && nr < box && nc >= 0 && nc < box && pip[nr * box + nc] >= 0;
+                }
+                if (!touches) continue;
+                for (int k = 0; k < 4; k++) {
+                    int nr = r + dr[k], nc = c + dc[k];
+                    if (nr < 0 || nr >= box || nc < 0 || nc >= box || pip[nr * box + nc] >= 0) continue;
+                    candidates.push_back({idx, nr * box + nc});
+                }
+            }
+            if (candidates.empty()) return false;
+            tie(a, b) = candidates[rng.below(candidates.size())];
+        }
+        bool flip = rng.chance(0.5);
+        pip[a] = flip ? dominoes[d].high : dominoes[d].low;
+        pip[b] = flip ? dominoes[d].low : dominoes[d].high;
+    }
+
+    int min_r = box, max_r = 0, min_c = box, max_c = 0;
+    for (int idx = 0; idx < box * box; idx++) {
+        if (pip[idx] < 0) continue;
+        min_r = min(min_r, idx / box); max_r = max(max_r, idx / box);
+        min_c = min(min_c, idx % box); max_c = max(max_c, idx % box);
+    }
+    rows = max_r - min_r + 1;
+    cols = max_c - min_c + 1;
+
+    // Grow regions from random unassigned cells
+    vector<int> region_of(box * box, -1);
+    vector<int> unassigned;
+    for (int idx = 0; idx < box * box; idx++) {
+        if (pip[idx] >= 0) unassigned.push_back(idx);
+    }
+    regions.clear();
+    while (!unassigned.empty()) {
+        int id = regions.size();
+        int start = unassigned[rng.below(unassigned.size())];
+        int target_size = 1 + rng.below(4);
+        vector<int> members = {start};
+        region_of[start] = id;
+        while ((int)members.size() < target_size) {
+            frontier.clear();
+            for (int idx : members) {
+                for (int k = 0; k < 4; k++) {
+                    int nr = idx / box + dr[k], nc = idx % box + dc[k];
+                    if (nr < 0 || nr >= box || nc < 0 || nc >= box) continue;
+                    int n = nr * box + nc;
+                    if (pip[n] >= 0 && region_of[n] < 0) frontier.push_back(n);
+                }
+            }
+            if (frontier.empty()) break;
+            int n = frontier[rng.below(frontier.size())];
+            region_of[n] = id;
+            members.push_back(n);
+        }
+        unassigned.erase(remove_if(unassigned.begin(), unassigned.end(),
+                                   [&](int idx) { return region_of[idx] >= 0; }),
+                         unassigned.end());
+
+        Region region{id, {}, ConstraintType::SUM, 0, -1};
+        uint16_t seen = 0;
+        bool all_equal = true, all_distinct = true;
+        for (int idx : members) {
+            region.cells.push_back({idx / box - min_r, idx % box - min_c});
+            region.target_value += pip[idx];
+            all_equal = all_equal && pip[idx] == pip[members[0]];
+            all_distinct = all_distinct && !(seen & (1u << pip[idx]));
+            seen |= 1u << pip[idx];
+        }
+
+        // Constraint mix loosely follows the NYT archive
+        int size = members.size();
+        if (size == 1 && rng.chance(0.3)) {
+            region.type = ConstraintType::EMPTY;
+        } else if (size > 1 && all_equal && rng.chance(0.7)) {
+            region.type = ConstraintType::EQUAL;
+        } else if (size > 1 && all_distinct && rng.chance(0.3)) {
+            region.type = ConstraintType::UNEQUAL;
+        } else if (rng.chance(0.2)) {
+            region.type = ConstraintType::LESS;
+            region.target_value += 1 + rng.below(2);
+        } else if (region.target_value > 0 && rng.chance(0.2)) {
+            region.type = ConstraintType::GREATER;
+            region.target_value -= 1 + rng.below(min(2, region.target_value));
+        }
+        if (region.type == ConstraintType::EQUAL || region.type == ConstraintType::UNEQUAL ||
+            region.type == ConstraintType::EMPTY) {
+            region.target_value = -1;
+        }
+        regions.push_back(move(region));
+    }
+    return true;
+}
+
+// Change one region so that the filling want still satisfies it and the
+// competing filling other does not, among regions where the two differ.
+// Only tightenings are made, so the puzzle's solutions can only shrink:
+// an unconstrained region gets EQUAL or UNEQUAL, else a threshold, a loose
+// threshold is pulled up to want's sum or pinned to it, and failing all
+// of those a SUM, threshold or unconstrained region is split into a cell
+// pinned to its pip and the rest summed to want's remainder. Pips are by
+// dense cell index. False when no region tells the fillings apart.
+bool separate_fillings(vector<Region>& regions, int cols, const array<uint8_t, MAX_CELLS>& want,
+                       const array<uint8_t, MAX_CELLS>& other) {
+    auto pip = [cols](const array<uint8_t, MAX_CELLS>& pips, Cell c) {
+        return (int)pips[c.first * cols + c.second];
+    };
+    // Most differing cells first
+    vector<pair<int, int>> order;
+    for (size_t i = 0; i < regions.size(); i++) {
+        int differing = 0;
+        for (Cell c : regions[i].cells) differing += pip(want, c) != pip(other, c);
+        if (differing) order.push_back({-differing, (int)i});
+    }
+    sort(order.begin(), order.end());
+
+    for (auto [_, i] : order) {
+        Region& r = regions[i];
+        int want_sum = 0, other_sum = 0;
+        uint16_t want_seen = 0, other_seen = 0;
+        bool want_equal = true, other_equal = true, want_distinct = true, other_distinct = true;
+        for (Cell c : r.cells) {
+            int a = pip(want, c), b = pip(other, c);
+            want_sum += a;
+            other_sum += b;
+            want_equal = want_equal && a == pip(want, r.cells[0]);
+            other_equal = other_equal && b == pip(other, r.cells[0]);
+            want_distinct = want_distinct && !(want_seen & (1u << a));
+            other_distinct = other_distinct && !(other_seen & (1u << b));
+            want_seen |= 1u << a;
+            other_seen |= 1u << b;
+        }
+        bool threshold = (r.type == ConstraintType::LESS || r.type == ConstraintType::GREATER) &&
+                         r.linked_region_id < 0;
+        if (r.type == ConstraintType::EMPTY) {
+            if (r.cells.size() > 1 && want_equal && !other_equal) {
+                r.type = ConstraintType::EQUAL;
+            } else if (r.cells.size() > 1 && want_distinct && !other_distinct) {
+                r.type = ConstraintType::UNEQUAL;
+            } else if (other_sum > want_sum) {
+                r.type = ConstraintType::LESS;
+                r.target_value = want_sum + 1;
+            } else if (other_sum < want_sum) {
+                r.type = ConstraintType::GREATER;
+                r.target_value = want_sum - 1;
+            } else {
+                continue;
+            }
+            return true;
+        }
+        if (threshold && want_sum != other_sum) {
+            if (r.type == ConstraintType::LESS && other_sum > want_sum) r.target_value = want_sum + 1;
+            else if (r.type == ConstraintType::GREATER && other_sum < want_sum) r.target_value = want_sum - 1;
+            else {
+                r.type = ConstraintType::SUM;
+                r.target_value = want_sum;
+            }
+            return true;
+        }
+    }
+
+    // Split off a differing cell whose removal leaves the rest connected.
+    // Regions others compare against keep their cells, as the comparison
+    // would loosen with the smaller sum.
+    for (auto [_, i] : order) {
+        const Region& r = regions[i];
+        bool splittable = r.type == ConstraintType::SUM || r.type == ConstraintType::EMPTY ||
+                          ((r.type == ConstraintType::LESS || r.type == ConstraintType::GREATER) &&
+                           r.linked_region_id < 0);
+        bool compared = any_of(regions.begin(), regions.end(), [&](const Region& q) {
+            return q.linked_region_id == r.id;
+        });
+        if (!splittable || compared || r.cells.size() < 2) continue;
+        for (size_t k = 0; k < r.cells.size(); k++) {
+            Cell cut = r.cells[k];
+            if (pip(want, cut) == pip(other, cut)) continue;
+            vector<Cell> rest = r.cells;
+            rest.erase(rest.begin() + k);
+            vector<Cell> reached = {rest[0]};
+            for (size_t j = 0; j < reached.size(); j++) {
+                for (Cell c : rest) {
+                    if (abs(c.first - reached[j].first) + abs(c.second - reached[j].second) == 1 &&
+                        find(reached.begin(), reached.end(), c) == reached.end()) reached.push_back(c);
+                }
+            }
+            if (reached.size() < rest.size()) continue;
+
+            int max_id = 0;
+            for (const auto& region : regions) max_id = max(max_id, region.id);
+            bool was_empty = r.type == ConstraintType::EMPTY;
+            int rest_sum = 0;
+            for (Cell c : rest) rest_sum += pip(want, c);
+            Region piece{max_id + 1, {cut}, ConstraintType::SUM, pip(want, cut), -1};
+            regions[i].cells = rest;
+            if (!was_empty) {
+                regions[i].type = ConstraintType::SUM;
+                regions[i].target_value = rest_sum;
+            }
+            regions.push_back(move(piece));
+            return true;
+        }
+    }
+    return false;
+}
+
+// Make a puzzle unique by repeatedly separating its first filling from
+// a competing one (separate_fillings()) and solving again. Each step
+// removes at least the competitor, so this takes a few solves where a
+// target sweep would take many. True once unique, with regions refined
+// and solution set; false if the puzzle has no solution, no region tells
+// two fillings apart, or max_steps refinements do not do. solves counts
+// the solves either way.
+bool refine_to_unique(const vector<Domino>& dominoes, int rows, int cols, vector<Region>& regions,
+                      vector<PlacedDomino>& solution, int max_steps, Engine engine, int& solves) {
+    array<uint8_t, MAX_CELLS> want{};
+    for (solves = 1; ; solves++) {
+        Solver solver(dominoes, regions, rows, cols, 2);
+        solver.keep_second = true;
+        int count = solve_with(solver, engine);
+        if (count == 0) return false;
+        if (solves == 1) {
+            want = solver.first_pips;
+            solution = solver.first_solution;
+        }
+        if (count == 1) return true;
+        const auto& other = solver.first_pips == want ? solver.second_pips : solver.first_pips;
+        if (solves > max_steps || !separate_fillings(regions, cols, want, other)) return false;
+    }
+}
+
+// Board and regions of one of the fixed search layouts. OPEN_TARGET
+// regions are swept; Medium's last target is set per attempt.
+struct Layout {
+    int rows, cols;
+    vector<Region> regions;
+};
+
+// 2x4 grid with 4 dominoes - inequality chain A < B < C < D over 4
+// regions of 2 cells, sweeping every sum target for D at once
+Layout easy1_layout() {
+    return {2, 4, {
+        {0, {{0,0}, {0,1}}, ConstraintType::LESS, -1, 1},
+        {1, {{0,2}, {0,3}}, ConstraintType::LESS, -1, 2},
+        {2, {{1,0}, {1,1}}, ConstraintType::LESS, -1, 3},
+        {3, {{1,2}, {1,3}}, ConstraintType::SUM, OPEN_TARGET, -1}
+    }};
+}
+
+// 2x4 grid with 3-cell regions (forces spanning), all sums swept
+Layout easy2_layout() {
+    return {2, 4, {
+        {0, {{0,0}, {0,1}, {1,0}}, ConstraintType::SUM, OPEN_TARGET, -1},
+        {1, {{0,2}, {0,3}, {1,3}}, ConstraintType::SUM, OPEN_TARGET, -1},
+        {2, {{1,1}, {1,2}}, ConstraintType::SUM, OPEN_TARGET, -1}
+    }};
+}
+
+// 3x4 grid with 6 dominoes - 6 horizontal pairs chained
+// 0 < 1 < 2 < 3 < 4 < 5 with a sum constraint on 5
+Layout medium_layout() {
+    return {3, 4, {
+        {0, {{0,0}, {0,1}}, ConstraintType::LESS, -1, 1},
+        {1, {{0,2}, {0,3}}, ConstraintType::LESS, -1, 2},
+        {2, {{1,0}, {1,1}}, ConstraintType::LESS, -1, 3},
+        {3, {{1,2}, {1,3}}, ConstraintType::LESS, -1, 4},
+        {4, {{2,0}, {2,1}}, ConstraintType::LESS, -1, 5},
+        {5, {{2,2}, {2,3}}, ConstraintType::SUM, OPEN_TARGET, -1}
+    }};
+}
+
+// 2x8 grid with 8 dominoes - 4 regions of 4 cells chained A < B < C < D,
+// with D's sum target left open for search_hard() to try one at a time
+Layout hard_layout() {
+    return {2, 8, {
+        {0, {{0,0}, {0,1}, {1,0}, {1,1}}, ConstraintType::LESS, -1, 1},
+        {1, {{0,2}, {0,3}, {1,2}, {1,3}}, ConstraintType::LESS, -1, 2},
+        {2, {{0,4}, {0,5}, {1,4}, {1,5}}, ConstraintType::LESS, -1, 3},
+        {3, {{0,6}, {0,7}, {1,6}, {1,7}}, ConstraintType::SUM, OPEN_TARGET, -1}
+    }};
+}
+
+// Search functions for each difficulty
+void search_easy_2x4_sums(int thread_id, const CombinationSpace& combos,
+                          uint64_t begin, uint64_t end) {
+    // Compiled once per process, so each thread's solver keeps its tables
+    static const Layout layout = easy1_layout();
+    static const CompiledLayout compiled(layout.regions, layout.rows, layout.cols);
+    int rows = layout.rows, cols = layout.cols;
+
+    vector<int> idx;
+    vector<Domino> set;
+    vector<Region> regions = layout.regions;   // With the targets of a result
+    BatchPrefilter batch(layout.regions, combos.set_size());
+    combos.unrank(begin, idx);
+
+    for (uint64_t i = begin; i < end; ) {
+        if (found_easy1.done(i)) return;
+
+        uint64_t first = i;
+        batch.clear();
+        for (; i < end && !batch.full(); i++, combos.next(idx)) {
+            combos.materialize(idx, set);
+            batch.add(set, layout.regions);
+        }
+        total_attempts.add(batch.size());
+        batch.run();
+
+        for (int lane = 0; lane < batch.size(); lane++) {
+            uint64_t rank = first + lane;
+            if (found_easy1.done(rank)) return;
+            if (!batch.passed(lane)) continue;
+            const vector<Domino>& dominoes = batch.dominoes(lane);
+
+            for (const SweepEntry* entry : sweep_targets(compiled, dominoes, search_engine)) {
+                if (found_easy1.done(rank)) return;
+                int target3 = entry->targets[0];
+                if (target3 < 1 || target3 > 12 || entry->count != 1) continue;
+
+                regions[3].target_value = target3;
+                const vector<PlacedDomino>& solution = entry->solution;
+                if (collector.enabled()) {
+                    collector.add(thread_id, "Easy1_IneqChain", regions, rows, cols, solution);
+                    continue;
+                }
+                if (candidates.enabled()) {
+                    PuzzleResult result{dominoes, regions, rows, cols, "Easy1_IneqChain", solution};
+                    if (!candidates.add(Difficulty::EASY1, move(result))) found_easy1.set = true;
+                    continue;
+                }
+                lock_guard<mutex> lock(console_mutex);
+                if (claim(found_easy1, rank)) {
+                    easy1_result = PuzzleResult{
+                        dominoes, regions, rows, cols, "Easy1_IneqChain", solution
+                    };
+                    cout << "[Thread " << thread_id << "] Found Easy1! Attempts: "
+                         << total_attempts.load() << " at rank " << rank << endl;
+                }
+                return;
+            }
+        }
+    }
+}
+
+void search_easy_3cell_regions(int thread_id, const CombinationSpace& combos,
+                               uint64_t begin, uint64_t end) {
+    static const Layout layout = easy2_layout();
+    static const CompiledLayout compiled(layout.regions, layout.rows, layout.cols);
+    int rows = layout.rows, cols = layout.cols;
+
+    vector<int> idx;
+    vector<Domino> set;
+    vector<Region> regions = layout.regions;   // With the targets of a result
+    BatchPrefilter batch(layout.regions, combos.set_size());
+    combos.unrank(begin, idx);
+
+    for (uint64_t i = begin; i < end; ) {
+        if (found_easy2.done(i)) return;
+
+        uint64_t first = i;
+        batch.clear();
+        for (; i < end && !batch.full(); i++, combos.next(idx)) {
+            combos.materialize(idx, set);
+            batch.add(set, layout.regions);
+        }
+        total_attempts.add(batch.size());
+        batch.run();
+
+        for (int lane = 0; lane < batch.size(); lane++) {
+            uint64_t rank = first + lane;
+            if (found_easy2.done(rank)) return;
+            if (!batch.passed(lane)) continue;
+            const vector<Domino>& dominoes = batch.dominoes(lane);
+
+            // Sweep all sum combinations in one pass
+            for (const SweepEntry* entry : sweep_targets(compiled, dominoes, search_engine)) {
+                if (found_easy2.done(rank)) return;
+                if (entry->count != 1) continue;
+
+                for (int r = 0; r < 3; r++) regions[r].target_value = entry->targets[r];
+                const vector<PlacedDomino>& solution = entry->solution;
+                if (collector.enabled()) {
+                    collector.add(thread_id, "Easy2_ForcedSpan", regions, rows, cols, solution);
+                    continue;
+                }
+                if (candidates.enabled()) {
+                    PuzzleResult result{dominoes, regions, rows, cols, "Easy2_ForcedSpan", solution};
+                    if (!candidates.add(Difficulty::EASY2, move(result))) found_easy2.set = true;
+                    continue;
+                }
+                lock_guard<mutex> lock(console_mutex);
+                if (claim(found_easy2, rank)) {
+                    easy2_result = PuzzleResult{
+                        dominoes, regions, rows, cols, "Easy2_ForcedSpan", solution
+                    };
+                    cout << "[Thread " << thread_id << "] Found Easy2! Attempts: "
+                         << total_attempts.load() << " at rank " << rank << endl;
+                }
+                return;
+            }
+        }
+    }
+}
+
+void search_medium(int thread_id, const CombinationSpace& combos,
+                   uint64_t begin, uint64_t end) {
+    static const Layout layout = medium_layout();
+    static const CompiledLayout compiled(layout.regions, layout.rows, layout.cols);
+    int rows = layout.rows, cols = layout.cols;
+
+    vector<int> idx;
+    vector<Domino> set;
+    vector<Region> regions = layout.regions;
+    vector<PlacedDomino> solution;
+    BatchPrefilter batch(layout.regions, combos.set_size());
+    array<uint64_t, BatchPrefilter::LANES> ranks;
+    combos.unrank(begin, idx);
+
+    for (uint64_t i = begin; i < end; ) {
+        if (found_medium.done(i)) return;
+
+        // Queue each set under the three targets tried for it, noting its rank
+        batch.clear();
+        for (; i < end && batch.size() + 3 <= BatchPrefilter::LANES; i++, combos.next(idx)) {
+            combos.materialize(idx, set);
+
+            // Get all domino sums
+            vector<int> sums;
+            for (const auto& d : set) sums.push_back(d.pips());
+
+            // Sort sums to check if they're distinct
+            vector<int> sorted_sums = sums;
+            sort(sorted_sums.begin(), sorted_sums.end());
+
+            // For inequality chain to work well, we want distinct sums
+            bool distinct = true;
+            for (size_t j = 1; j < sorted_sums.size(); j++) {
+                if (sorted_sums[j] == sorted_sums[j-1]) {
+                    distinct = false;
+                    break;
+                }
+            }
+            if (!distinct) continue;
+
+            int max_sum = sorted_sums.back();
+            for (int target5 = max_sum; target5 <= max_sum + 2; target5++) {
+                regions[5].target_value = target5;
+                ranks[batch.size()] = i;
+                batch.add(set, regions);
+            }
+        }
+        total_attempts.add(batch.size());
+        batch.run();
+
+        for (int lane = 0; lane < batch.size(); lane++) {
+            uint64_t rank = ranks[lane];
+            if (found_medium.done(rank)) return;
+            if (!batch.passed(lane)) continue;
+            const vector<Domino>& dominoes = batch.dominoes(lane);
+            regions[5].target_value = batch.target_of(lane, 5);
+
+            int count = test_puzzle(compiled, dominoes, regions, &solution, search_engine);
+
+            if (count == 1 && collector.enabled()) {
+                collector.add(thread_id, "Medium_InequalityChain", regions, rows, cols, solution);
+            } else if (count == 1 && candidates.enabled()) {
+                PuzzleResult result{dominoes, regions, rows, cols, "Medium_InequalityChain", solution};
+                if (!candidates.add(Difficulty::MEDIUM, move(result))) found_medium.set = true;
+            } else if (count == 1) {
+                lock_guard<mutex> lock(console_mutex);
+                if (claim(found_medium, rank)) {
+                    medium_result = PuzzleResult{
+                        dominoes, regions, rows, cols, "Medium_InequalityChain", solution
+                    };
+                    cout << "[Thread " << thread_id << "] Found Medium! Attempts: "
+                         << total_attempts.load() << " at rank " << rank << endl;
+                }
+                return;
+            }
+        }
+    }
+}
+
+void search_hard(int thread_id, const CombinationSpace& combos,
+                 uint64_t begin, uint64_t end) {
+    static const Layout layout = hard_layout();
+    static const CompiledLayout compiled(layout.regions, layout.rows, layout.cols);
+    int rows = layout.rows, cols = layout.cols;
+
+    vector<int> idx;
+    vector<Domino> set;
+    vector<Region> regions = layout.regions;   // With the targets of a result
+    vector<PlacedDomino> solution;
+    BatchPrefilter batch(layout.regions, combos.set_size());
+    combos.unrank(begin, idx);
+
+    for (uint64_t rank = begin; rank < end; rank++, combos.next(idx)) {
+        if (found_hard.done(rank)) return;
+        combos.materialize(idx, set);
+        int total = 0;
+        for (const auto& d : set) total += d.pips();
+
+        // Each target for D is an attempt of its own, queued in ascending
+        // batches: a fixed target prunes the chain early, and the lowest
+        // unique one usually turns up long before a sweep would finish
+        for (int next = 1; next < total; ) {
+            if (found_hard.done(rank)) return;
+            batch.clear();
+            for (; next < total && !batch.full(); next++) {
+                regions[3].target_value = next;
+                batch.add(set, regions);
+            }
+            total_attempts.add(batch.size());
+            batch.run();
+
+            for (int lane = 0; lane < batch.size(); lane++) {
+                if (found_hard.done(rank)) return;
+                if (!batch.passed(lane)) continue;
+                const vector<Domino>& dominoes = batch.dominoes(lane);
+                regions[3].target_value = batch.target_of(lane, 3);
+                if (test_puzzle(compiled, dominoes, regions, &solution, search_engine) != 1) continue;
+                if (collector.enabled()) {
+                    collector.add(thread_id, "Hard_D9Remainder", regions, rows, cols, solution);
+                    continue;
+                }
+                if (candidates.enabled()) {
+                    PuzzleResult result{dominoes, regions, rows, cols, "Hard_D9Remainder", solution};
+                    if (!candidates.add(Difficulty::HARD, move(result))) found_hard.set = true;
+                    continue;
+                }
+                lock_guard<mutex> lock(console_mutex);
+                if (claim(found_hard, rank)) {
+                    hard_result = PuzzleResult{
+                        dominoes, regions, rows, cols, "Hard_D9Remainder", solution
+                    };
+                    cout << "[Thread " << thread_id << "] Found Hard! Attempts: "
+                         << total_attempts.load() << " at rank " << rank << endl;
+                }
+                return;
+            }
+        }
+    }
+}
+
+// Random mode keeps the samples that are unique as drawn; refine mode
+// passes the others through refine_to_unique()
+void search_random(int thread_id, uint64_t seed, const vector<Domino>& pool, int num_dominoes,
+                   bool refine, uint64_t begin, uint64_t end) {
+    const string prefix = refine ? "Refined_" : "Random_";
+    // Smallest square box that leaves room to grow the board
+    int box = 4;
+    while (box * box < 4 * num_dominoes) box++;
+
+    vector<Domino> dominoes;
+    vector<Region> regions;
+    int rows, cols;
+
+    for (uint64_t i = begin; i < end; i++) {
+        Rng rng(seed, i);
+        if (!random_puzzle(rng, pool, num_dominoes, box, dominoes, regions, rows, cols)) continue;
+        total_attempts++;
+
+        vector<PlacedDomino> solution;
+        if (refine) {
+            int solves;
+            bool unique = refine_to_unique(dominoes, rows, cols, regions, solution, REFINE_STEPS,
+                                           search_engine, solves);
+            refine_solves.add(solves);
+            if (!unique) continue;
+        } else if (check_uniqueness(dominoes, rows, cols, regions, &solution, search_engine) !=
+                   Uniqueness::UNIQUE) {
+            continue;
+        }
+
+        found_random++;
+        if (collector.enabled()) {
+            collector.add(thread_id, prefix + to_string(i), regions, rows, cols, solution);
+            continue;
+        }
+        RandomSlot& slot = random_slots[thread_id];
+        if (i >= slot.sample) continue;
+        slot.sample = i;
+        slot.result = PuzzleResult{dominoes, regions, rows, cols, prefix + to_string(i), solution};
+
+        // Announce only samples that lower the best seen by any worker
+        uint64_t best = random_best_sample.load();
+        while (i < best && !random_best_sample.compare_exchange_weak(best, i)) {}
+        if (i < best) {
+            lock_guard<mutex> lock(console_mutex);
+            cout << "[Thread " << thread_id << "] Unique " << (refine ? "refined" : "random")
+                 << " puzzle at sample " << i
+                 << "! Attempts: " << total_attempts.load() << endl;
+        }
+    }
+}
+
+// Unicode box drawing characters
+const string BOX_TL = "┌";
+const string BOX_TR = "┐";
+const string BOX_BL = "└";
+const string BOX_BR = "┘";
+const string BOX_H = "─";
+const string BOX_V = "│";
+const string BOX_CROSS = "┼";
+const string BOX_T_DOWN = "┬";
+const string BOX_T_UP = "┴";
+const string BOX_T_RIGHT = "├";
+const string BOX_T_LEFT = "┤";
+
+// Thick box drawing for region boundaries
+const string THICK_H = "━";
+const string THICK_V = "┃";
+
+void draw_puzzle_grid(const PuzzleResult& result) {
+    int rows = result.rows;
+    int cols = result.cols;
+
+    // Build cell-to-region map
+    map<Cell, int> cell_region;
+    for (const auto& r : result.regions) {
+        for (const auto& c : r.cells) {
+            cell_region[c] = r.id;
+        }
+    }
+
+    // Build cell-to-pip map from solution
+    map<Cell, int> cell_pip;
+    for (const auto& p : result.solution) {
+        Cell c1 = p.cell1();
+        Cell c2 = p.cell2();
+        cell_pip[c1] = p.pip1();
+        cell_pip[c2] = p.pip2();
+    }
+
+    // Region labels
+    map<int, string> region_label;
+    for (const auto& r : result.regions) {
+        if (r.type == ConstraintType::SUM) {
+            region_label[r.id] = to_string(r.target_value);
+        } else if (r.type == ConstraintType::LESS) {
+            region_label[r.id] = "<" + to_string(r.linked_region_id < 0 ? r.target_value : r.linked_region_id);
+        } else if (r.type == ConstraintType::EQUAL) {
+            region_label[r.id] = "=";
+        } else if (r.type == ConstraintType::GREATER) {
+            region_label[r.id] = ">" + to_string(r.linked_region_id < 0 ? r.target_value : r.linked_region_id);
+        } else if (r.type == ConstraintType::UNEQUAL) {
+            region_label[r.id] = "!=";
+        }
+    }
+
+    // Draw grid
+    int cell_width = 5;
+    string h_line(cell_width, '-');
+
+    // Top border
+    cout << "  ";
+    for (int c = 0; c < cols; c++) {
+        cout << "+" << h_line;
+    }
+    cout << "+" << endl;
+
+    for (int r = 0; r < rows; r++) {
+        // Cell content row
+        cout << "  ";
+        for (int c = 0; c < cols; c++) {
+            Cell cell = {r, c};
+            cout << "|";
+
+            // Off-board cells of an irregular layout stay blank
+            auto it = cell_region.find(cell);
+            if (it == cell_region.end()) {
+                cout << string(cell_width, ' ');
+                continue;
+            }
+
+            // Show region label in top-left cell of region, pip value otherwise
+            bool show_label = true;
+            int rid = it->second;
+            for (const auto& cr : result.regions[rid].cells) {
+                if (cr.first < r || (cr.first == r && cr.second < c)) {
+                    show_label = false;
+                    break;
+                }
+            }
+
+            string content;
+            if (show_label && region_label.count(rid)) {
                 content = region_label[rid];
             } else if (cell_pip.count(cell)) {
                 content = to_string(cell_pip[cell]);
             } else {
-                content = " ";
+                content = " ";
+            }
+
+            // Center content in cell
+            int pad_left = (cell_width - content.length()) / 2;
+            int pad_right = cell_width - content.length() - pad_left;
+            cout << string(pad_left, ' ') << content << string(pad_right, ' ');
+        }
+        cout << "|" << endl;
+
+        // Horizontal line between rows
+        cout << "  ";
+        for (int c = 0; c < cols; c++) {
+            cout << "+" << h_line;
+        }
+        cout << "+" << endl;
+    }
+}
+
+void print_result(const string& name, const optional<PuzzleResult>& result) {
+    if (!result) {
+        cout << name << ": NOT FOUND" << endl;
+        return;
+    }
+
+    cout << "\n" << string(50, '=') << endl;
+    cout << name << ": FOUND!" << endl;
+    cout << string(50, '=') << endl;
+
+    cout << "Grid: " << result->rows << "x" << result->cols << endl;
+    cout << "Dominoes: ";
+    for (const auto& d : result->dominoes) {
+        cout << d.str() << " ";
+    }
+    cout << endl << endl;
+
+    // Draw puzzle grid
+    cout << "PUZZLE:" << endl;
+    draw_puzzle_grid(*result);
+
+    // Draw solution with domino boundaries
+    cout << endl << "SOLUTION:" << endl;
+    int rows = result->rows;
+    int cols = result->cols;
+    int cell_width = 5;
+    string h_line(cell_width, '-');
+    string h_space(cell_width, ' ');
+
+    // Build cell-to-pip and cell-to-domino maps
+    map<Cell, int> cell_pip;
+    map<Cell, int> cell_domino;  // Which domino each cell belongs to
+    for (size_t i = 0; i < result->solution.size(); i++) {
+        const auto& p = result->solution[i];
+        Cell c1 = p.cell1();
+        Cell c2 = p.cell2();
+        cell_pip[c1] = p.pip1();
+        cell_pip[c2] = p.pip2();
+        cell_domino[c1] = i;
+        cell_domino[c2] = i;
+    }
+
+    // Top border
+    cout << "  ";
+    for (int c = 0; c < cols; c++) cout << "+" << h_line;
+    cout << "+" << endl;
+
+    for (int r = 0; r < rows; r++) {
+        // Content row
+        cout << "  ";
+        for (int c = 0; c < cols; c++) {
+            Cell cell = {r, c};
+            Cell left = {r, c - 1};
+
+            // Vertical border: show if edge or different domino
+            bool show_border = (c == 0) || !cell_domino.count(left) ||
+                              cell_domino[left] != cell_domino[cell];
+            cout << (show_border ? "|" : " ");
+
+            string content = cell_pip.count(cell) ? to_string(cell_pip[cell]) : " ";
+            int pad_left = (cell_width - content.length()) / 2;
+            int pad_right = cell_width - content.length() - pad_left;
+            cout << string(pad_left, ' ') << content << string(pad_right, ' ');
+        }
+        cout << "|" << endl;
+
+        // Horizontal line: show segment if edge or different domino from below
+        cout << "  ";
+        for (int c = 0; c < cols; c++) {
+            Cell above = {r, c};
+            Cell below = {r + 1, c};
+
+            bool show_h_border = (r == rows - 1) || !cell_domino.count(below) ||
+                                 cell_domino[above] != cell_domino[below];
+            cout << "+" << (show_h_border ? h_line : h_space);
+        }
+        cout << "+" << endl;
+    }
+
+    // Output Python code
+    cout << endl << "Python code for puzzles.py:" << endl;
+    cout << "  dominoes = [";
+    for (size_t i = 0; i < result->dominoes.size(); i++) {
+        if (i > 0) cout << ", ";
+        cout << "Domino(" << result->dominoes[i].low << ", " << result->dominoes[i].high << ")";
+    }
+    cout << "]" << endl;
+
+    cout << "  regions = [" << endl;
+    for (const auto& r : result->regions) {
+        cout << "    Region(" << r.id << ", [";
+        for (size_t i = 0; i < r.cells.size(); i++) {
+            if (i > 0) cout << ", ";
+            cout << "(" << r.cells[i].first << ", " << r.cells[i].second << ")";
+        }
+        cout << "], ConstraintType.";
+        if (r.type == ConstraintType::SUM) cout << "SUM, target_value=" << r.target_value;
+        else if (r.type == ConstraintType::LESS && r.linked_region_id < 0) cout << "LESS, target_value=" << r.target_value;
+        else if (r.type == ConstraintType::LESS) cout << "LESS, linked_region_id=" << r.linked_region_id;
+        else if (r.type == ConstraintType::EQUAL) cout << "EQUAL";
+        else if (r.type == ConstraintType::GREATER && r.linked_region_id < 0) cout << "GREATER, target_value=" << r.target_value;
+        else if (r.type == ConstraintType::GREATER) cout << "GREATER, linked_region_id=" << r.linked_region_id;
+        else if (r.type == ConstraintType::UNEQUAL) cout << "UNEQUAL";
+        else if (r.type == ConstraintType::EMPTY) cout << "SUM, target_value=None";
+        cout << ")," << endl;
+    }
+    cout << "  ]" << endl;
+}
+
+void print_usage() {
+    cout << "Usage: puzzle_gen [mode] [options]" << endl;
+    cout << "Modes:" << endl;
+    cout << "  easy        - Generate Easy1 + Easy2 (Easy2 from remainder after Easy1)" << endl;
+    cout << "  medium-hard - Generate Medium + Hard (Hard from remainder after Medium)" << endl;
+    cout << "  easy1       - Generate Easy1 only" << endl;
+    cout << "  easy2 [d1] [d2] [d3] [d4] - Generate Easy2 excluding specified dominoes" << endl;
+    cout << "  medium      - Generate Medium only" << endl;
+    cout << "  hard [d1] ... [d6] - Generate Hard excluding specified dominoes" << endl;
+    cout << "  all         - Generate all puzzles (default)" << endl;
+    cout << "  daily [d1] ... - Search all four difficulties at once and pack a disjoint set," << endl;
+    cout << "                excluding specified dominoes" << endl;
+    cout << "  verify <files...> - Check NYT puzzle JSON files have unique, matching solutions;" << endl;
+    cout << "                with fewer puzzles than threads, each solve auto would not give" << endl;
+    cout << "                to sat (every solve with --engine backtrack) is split across" << endl;
+    cout << "                the threads" << endl;
+    cout << "  random      - Sample random irregular layouts and keep the unique ones" << endl;
+    cout << "  refine      - Like random (same options), tightening the constraints of ambiguous samples until unique" << endl;
+    cout << "  bench       - Time the solver on a fixed corpus, optionally against a baseline" << endl;
+    cout << "  shard-check - Check that --shard runs find the same puzzles and stop as early" << endl;
+    cout << "  merge <files...> - Combine the shard reports of a --shard run" << endl;
+    cout << "\nOptions:" << endl;
+    cout << "  --threads N - Worker threads (default: hardware concurrency)" << endl;
+    cout << "  --engine E  - Solving engine: auto (default: sat from " << SAT_MIN_DOMINOES
+         << " dominoes, tilings below), tilings, backtrack, dlx or sat" << endl;
+    cout << "  --seed S    - Random mode: PRNG seed (default: 1)" << endl;
+    cout << "  --samples N - Random mode: layouts to sample (default: 100000)" << endl;
+    cout << "  --dominoes K - Random mode: dominoes per puzzle, 2-30 (default: 8)" << endl;
+    cout << "  --checkpoint F - Save search progress to F periodically (default: puzzle_gen.ckpt)" << endl;
+    cout << "  --checkpoint-interval S - Seconds between checkpoints (default: 30)" << endl;
+    cout << "  --resume    - Continue the searches recorded in the checkpoint file" << endl;
+    cout << "  --collect F - Append every unique puzzle found to F instead of stopping at the first" << endl;
+    cout << "  --format X  - Collect format: jsonl (default) or binary" << endl;
+    cout << "  --shard K/N - Search only shard K of N of the ranks, keeping the lowest-rank result" << endl;
+    cout << "  --shard-file F - Where a sharded run writes its report (default: puzzle_gen.K-of-N.shard)" << endl;
+    cout << "  --candidates N - Daily mode: unique puzzles gathered per difficulty (default: 16)" << endl;
+    cout << "  --baseline F - Bench mode: compare against the baseline in F" << endl;
+    cout << "  --save-baseline F - Bench mode: write this run's results to F" << endl;
+    cout << "  --tolerance P - Bench mode: slowdown in percent that counts as a regression (default: 10)" << endl;
+    cout << "  --progress S - Print search throughput, utilization and ETA every S seconds" << endl;
+    cout << "  --metrics F - Write the same telemetry to F in Prometheus text format" << endl;
+    cout << "\nDomino format: low-high (e.g., 0-0, 1-2, 3-6)" << endl;
+}
+
+vector<Domino> exclude_dominoes(const vector<Domino>& pool, const vector<Domino>& exclude) {
+    vector<Domino> result;
+    for (const auto& d : pool) {
+        bool found = false;
+        for (const auto& e : exclude) {
+            if (d == e) { found = true; break; }
+        }
+        if (!found) result.push_back(d);
+    }
+    return result;
+}
+
+Domino parse_domino(const string& s) {
+    size_t dash = s.find('-');
+    if (dash == string::npos) return {-1, -1};
+    int low = stoi(s.substr(0, dash));
+    int high = stoi(s.substr(dash + 1));
+    if (low > high) swap(low, high);
+    return {low, high};
+}
+
+// Minimal reader over an in-memory JSON document. Strings come back as
+// views into the buffer, so parsing copies nothing. On malformed input
+// the reader stops advancing and ok() turns false.
+class JsonReader {
+public:
+    explicit JsonReader(string_view text) : p(text.data()), end(text.data() + text.size()) {}
+
+    bool ok() const { return !failed; }
+
+    bool at_end() {
+        while (p < end && (*p == ' ' || *p == '\n' || *p == '\t' || *p == '\r')) p++;
+        return p >= end;
+    }
+
+    void expect(char c) {
+        if (peek() == c) p++;
+        else failed = true;
+    }
+
+    // Iterate members with `while (next_member(key))` after expect('{')
+    bool next_member(string_view& key) {
+        if (!more('}')) return false;
+        key = string_value();
+        expect(':');
+        return ok();
+    }
+
+    // Iterate elements with `while (next_element())` after expect('[')
+    bool next_element() { return more(']'); }
+
+    string_view string_value() {
+        if (peek() != '"') { failed = true; return {}; }
+        const char* start = ++p;
+        while (p < end && *p != '"') p += (*p == '\\') ? 2 : 1;
+        if (p >= end) { failed = true; return {}; }
+        return string_view(start, p++ - start);
+    }
+
+    int int_value() {
+        bool neg = peek() == '-';
+        if (neg) p++;
+        if (p >= end || *p < '0' || *p > '9') { failed = true; return 0; }
+        int value = 0;
+        while (p < end && *p >= '0' && *p <= '9') value = value * 10 + (*p++ - '0');
+        return neg ? -value : value;
+    }
+
+    void skip_value() {
+        char c = peek();
+        if (c == '"') {
+            string_value();
+        } else if (c == '{') {
+            p++;
+            string_view key;
+            while (next_member(key)) skip_value();
+        } else if (c == '[') {
+            p++;
+            while (next_element()) skip_value();
+        } else {
+            // Number, true, false or null
+            while (p < end && *p != ',' && *p != '}' && *p != ']' &&
+                   *p != ' ' && *p != '\n' && *p != '\t' && *p != '\r') p++;
+        }
+    }
+
+private:
+    const char* p;
+    const char* end;
+    bool failed = false;
+
+    char peek() {
+        while (p < end && (*p == ' ' || *p == '\n' || *p == '\t' || *p == '\r')) p++;
+        if (p >= end) { failed = true; return 0; }
+        return *p;
+    }
+
+    // Skip a separating comma; false (after consuming it) at the closer
+    bool more(char closer) {
+        if (failed) return false;
+        char c = peek();
+        if (c == ',') { p++; c = peek(); }
+        if (c == closer) { p++; return false; }
+        return ok();
+    }
+};
+
+// One easy/medium/hard entry of an NYT daily file
+struct NytPuzzle {
+    string label;                             // "<file> <difficulty>"
+    vector<Domino> dominoes;
+    vector<Region> regions;
+    int rows = 0, cols = 0;
+    array<uint8_t, MAX_CELLS> pips{};         // Recorded solution, by dense cell index
+    string unsupported;                       // Feature the solver lacks, if any
+};
+
+Cell read_cell(JsonReader& json) {
+    json.expect('[');
+    Cell cell;
+    cell.first = json.int_value();
+    json.next_element();
+    cell.second = json.int_value();
+    while (json.next_element()) json.skip_value();
+    return cell;
+}
+
+bool read_nyt_puzzle(JsonReader& json, NytPuzzle& puzzle) {
+    vector<array<int, 2>> pairs;              // Domino pips in file order
+    vector<pair<Cell, Cell>> placements;      // Solution cells per domino
+    int max_row = -1, max_col = -1;
+
+    json.expect('{');
+    string_view key;
+    while (json.next_member(key)) {
+        if (key == "dominoes") {
+            json.expect('[');
+            while (json.next_element()) {
+                Cell d = read_cell(json);
+                // The solver keeps pips in 4 bits
+                if (d.first < 0 || d.first > 15 || d.second < 0 || d.second > 15) return false;
+                pairs.push_back({d.first, d.second});
+            }
+        } else if (key == "regions") {
+            json.expect('[');
+            while (json.next_element()) {
+                Region region{(int)puzzle.regions.size(), {}, ConstraintType::SUM, OPEN_TARGET, -1};
+                string_view type;
+                bool has_target = false;
+                json.expect('{');
+                string_view field;
+                while (json.next_member(field)) {
+                    if (field == "indices") {
+                        json.expect('[');
+                        while (json.next_element()) {
+                            Cell cell = read_cell(json);
+                            if (cell.first < 0 || cell.second < 0) return false;
+                            max_row = max(max_row, cell.first);
+                            max_col = max(max_col, cell.second);
+                            region.cells.push_back(cell);
+                        }
+                    } else if (field == "type") {
+                        type = json.string_value();
+                    } else if (field == "target") {
+                        region.target_value = json.int_value();
+                        has_target = true;
+                    } else if (field == "linked") {
+                        region.linked_region_id = json.int_value();
+                    } else {
+                        json.skip_value();
+                    }
+                }
+                if (type == "equals") region.type = ConstraintType::EQUAL;
+                else if (type == "unequal") region.type = ConstraintType::UNEQUAL;
+                else if (type == "empty") region.type = ConstraintType::EMPTY;
+                else if (type == "less") region.type = ConstraintType::LESS;
+                else if (type == "greater") region.type = ConstraintType::GREATER;
+                else if (type != "sum" && puzzle.unsupported.empty()) puzzle.unsupported = type;
+                if (region.cells.empty()) return false;
+                // Without its target a sum or threshold region would go unchecked
+                bool threshold = (region.type == ConstraintType::LESS ||
+                                  region.type == ConstraintType::GREATER) && region.linked_region_id < 0;
+                if ((type == "sum" || threshold) && !has_target) return false;
+                puzzle.regions.push_back(move(region));
+            }
+            // Regions are numbered by position, so links must name one of them
+            for (const auto& region : puzzle.regions) {
+                if (region.linked_region_id < -1 ||
+                    region.linked_region_id >= (int)puzzle.regions.size()) return false;
+            }
+        } else if (key == "solution") {
+            json.expect('[');
+            while (json.next_element()) {
+                json.expect('[');
+                Cell a = read_cell(json);
+                json.next_element();
+                Cell b = read_cell(json);
+                while (json.next_element()) json.skip_value();
+                placements.push_back({a, b});
+            }
+        } else {
+            json.skip_value();
+        }
+    }
+    if (!json.ok()) return false;
+
+    puzzle.rows = max_row + 1;
+    puzzle.cols = max_col + 1;
+    if (puzzle.rows * puzzle.cols > MAX_CELLS || pairs.size() > 64) {
+        puzzle.unsupported = "board size";
+        return true;
+    }
+    for (const auto& d : pairs) puzzle.dominoes.push_back({min(d[0], d[1]), max(d[0], d[1])});
+    // The solution lists each domino's cells in the order of its pips
+    if (placements.size() != pairs.size()) return false;
+    for (size_t i = 0; i < pairs.size(); i++) {
+        for (Cell c : {placements[i].first, placements[i].second}) {
+            if (c.first < 0 || c.first >= puzzle.rows || c.second < 0 || c.second >= puzzle.cols) {
+                return false;
+            }
+        }
+        puzzle.pips[placements[i].first.first * puzzle.cols + placements[i].first.second] = pairs[i][0];
+        puzzle.pips[placements[i].second.first * puzzle.cols + placements[i].second.second] = pairs[i][1];
+    }
+    return true;
+}
+
+// Append the easy/medium/hard entries of one file; false if unreadable
+bool load_nyt_file(const string& path, vector<NytPuzzle>& out) {
+    ifstream in(path, ios::binary);
+    if (!in) return false;
+    string text((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+
+    JsonReader json(text);
+
+    // Collect-all output: one puzzle object per line
+    if (path.size() > 6 && path.compare(path.size() - 6, 6, ".jsonl") == 0) {
+        for (int line = 1; !json.at_end(); line++) {
+            NytPuzzle puzzle;
+            puzzle.label = path + ":" + to_string(line);
+            if (!read_nyt_puzzle(json, puzzle)) return false;
+            out.push_back(move(puzzle));
+        }
+        return true;
+    }
+
+    json.expect('{');
+    string_view key;
+    while (json.next_member(key)) {
+        if (key == "easy" || key == "medium" || key == "hard") {
+            NytPuzzle puzzle;
+            puzzle.label = path + " " + string(key);
+            if (!read_nyt_puzzle(json, puzzle)) return false;
+            out.push_back(move(puzzle));
+        } else {
+            json.skip_value();
+        }
+    }
+    return json.ok();
+}
+
+// Solve every puzzle in the given NYT files on the pool and check each has
+// exactly one solution, the recorded one. Returns the process exit code.
+int run_verify(const vector<string>& files, int num_threads) {
+    auto start = chrono::high_resolution_clock::now();
+    vector<NytPuzzle> puzzles;
+    int failed = 0;
+    for (const auto& path : files) {
+        if (!load_nyt_file(path, puzzles)) {
+            cout << path << ": FAILED (could not parse)" << endl;
+            failed++;
+        }
+    }
+
+    vector<string> verdicts(puzzles.size());
+    vector<bool> passed(puzzles.size(), false);
+    ThreadPool pool(num_threads);
+    auto check = [&](uint64_t i, ThreadPool* split) {
+        const NytPuzzle& puzzle = puzzles[i];
+        if (!puzzle.unsupported.empty()) {
+            verdicts[i] = "SKIPPED (unsupported: " + puzzle.unsupported + ")";
+            return;
+        }
+        auto t0 = chrono::high_resolution_clock::now();
+        Solver solver(puzzle.dominoes, puzzle.regions, puzzle.rows, puzzle.cols, 2);
+        int count = split ? solve_split(solver, *split) : solve_with(solver, search_engine);
+        auto us = chrono::duration_cast<chrono::microseconds>(
+            chrono::high_resolution_clock::now() - t0).count();
+
+        if (count == 0) verdicts[i] = "FAILED (no solution)";
+        else if (count > 1) verdicts[i] = "FAILED (multiple solutions)";
+        else if (solver.first_pips != puzzle.pips) verdicts[i] = "FAILED (differs from recorded solution)";
+        else {
+            verdicts[i] = "OK";
+            passed[i] = true;
+        }
+        verdicts[i] += " (" + to_string(us) + "us)";
+    };
+
+    // With fewer puzzles than workers, each solve is split across the pool
+    // instead: always when backtracking, and by default on the boards auto
+    // would not hand to SAT
+    vector<bool> split(puzzles.size(), false);
+    for (size_t i = 0; i < puzzles.size() && puzzles.size() < (size_t)pool.size(); i++) {
+        split[i] = search_engine == Engine::BACKTRACK ||
+                   (search_engine == Engine::AUTO && puzzles[i].dominoes.size() < SAT_MIN_DOMINOES);
+        if (split[i]) check(i, &pool);
+    }
+    parallel_for(pool, puzzles.size(), [&](int, uint64_t begin, uint64_t end) {
+        for (uint64_t i = begin; i < end; i++) {
+            if (!split[i]) check(i, nullptr);
+        }
+    });
+
+    int ok = 0, skipped = 0;
+    for (size_t i = 0; i < puzzles.size(); i++) {
+        cout << puzzles[i].label << ": " << verdicts[i] << endl;
+        if (passed[i]) ok++;
+        else if (!puzzles[i].unsupported.empty()) skipped++;
+        else failed++;
+    }
+    auto ms = chrono::duration_cast<chrono::milliseconds>(
+        chrono::high_resolution_clock::now() - start).count();
+    cout << "Verified " << ok << " puzzles, " << failed << " failed, " << skipped
+         << " skipped (" << ms << "ms)" << endl;
+    return failed ? 1 : 0;
+}
+
+// What one host of a --shard run found, saved for merge mode as
+// whitespace-separated text: the run's settings and counters, then each
+// search's result with the rank it came from (daily mode saves its
+// candidates instead). Results are tagged easy1, easy2, medium, hard or
+// random, and a puzzle is written as its name, grid size, dominoes,
+// regions and solution placements.
+struct ShardReport {
+    uint64_t index = 0, count = 1;
+    string mode;
+    vector<Domino> exclude;
+    uint64_t attempts = 0, unique = 0, collected = 0;
+    array<uint64_t, NUM_REJECTIONS> rejected{};
+    bool has_telemetry = false;
+    uint64_t nodes = 0, dead_ends = 0;
+    array<uint64_t, NUM_CONSTRAINT_TYPES + 1> pruned{};
+    map<string, pair<uint64_t, PuzzleResult>> results;   // Tag to (rank, result)
+    array<vector<PuzzleResult>, NUM_DIFFICULTIES> candidates;
+
+    bool save(const string& path) const {
+        string tmp = path + ".tmp";
+        {
+            ofstream out(tmp, ios::trunc);
+            out << MAGIC << " " << VERSION << "\n";
+            out << "shard " << index << " " << count << "\n";
+            out << "mode " << mode << "\n";
+            out << "exclude " << exclude.size();
+            for (const auto& d : exclude) out << " " << d.low << " " << d.high;
+            out << "\n";
+            out << "attempts " << attempts << " " << unique << " " << collected << "\n";
+            out << "rejected";
+            for (uint64_t r : rejected) out << " " << r;
+            out << "\n";
+            out << "telemetry " << has_telemetry << " " << nodes << " " << dead_ends;
+            for (uint64_t p : pruned) out << " " << p;
+            out << "\n";
+            for (const auto& [tag, ranked] : results) {
+                out << "result " << tag << " " << ranked.first << " ";
+                write_puzzle(out, ranked.second);
+            }
+            for (int d = 0; d < NUM_DIFFICULTIES; d++) {
+                for (const auto& result : candidates[d]) {
+                    out << "candidate " << d << " ";
+                    write_puzzle(out, result);
+                }
+            }
+            if (!out) return false;
+        }
+        return rename(tmp.c_str(), path.c_str()) == 0;
+    }
+
+    bool load(const string& path) {
+        ifstream in(path);
+        string magic, word;
+        int version = 0;
+        if (!(in >> magic >> version) || magic != MAGIC || version != VERSION) return false;
+        while (in >> word) {
+            if (word == "shard") {
+                in >> index >> count;
+            } else if (word == "mode") {
+                in >> mode;
+            } else if (word == "exclude") {
+                size_t n = 0;
+                in >> n;
+                exclude.resize(n);
+                for (auto& d : exclude) in >> d.low >> d.high;
+            } else if (word == "attempts") {
+                in >> attempts >> unique >> collected;
+            } else if (word == "rejected") {
+                for (auto& r : rejected) in >> r;
+            } else if (word == "telemetry") {
+                in >> has_telemetry >> nodes >> dead_ends;
+                for (auto& p : pruned) in >> p;
+            } else if (word == "result") {
+                string tag;
+                uint64_t rank = 0;
+                PuzzleResult result;
+                if (!(in >> tag >> rank) || !read_puzzle(in, result)) return false;
+                results[tag] = {rank, move(result)};
+            } else if (word == "candidate") {
+                int d = -1;
+                PuzzleResult result;
+                if (!(in >> d) || d < 0 || d >= NUM_DIFFICULTIES || !read_puzzle(in, result)) {
+                    return false;
+                }
+                candidates[d].push_back(move(result));
+            } else {
+                return false;
+            }
+            if (!in) return false;
+        }
+        return index < count;
+    }
+
+private:
+    static constexpr const char* MAGIC = "pips-shard";
+    static constexpr int VERSION = 1;
+
+    static void write_puzzle(ostream& out, const PuzzleResult& r) {
+        out << r.name << " " << r.rows << " " << r.cols << " " << r.dominoes.size();
+        for (const auto& d : r.dominoes) out << " " << d.low << " " << d.high;
+        out << " " << r.regions.size();
+        for (const auto& region : r.regions) {
+            out << " " << region.id << " " << (int)region.type << " " << region.target_value
+                << " " << region.linked_region_id << " " << region.cells.size();
+            for (Cell c : region.cells) out << " " << c.first << " " << c.second;
+        }
+        out << " " << r.solution.size();
+        for (const auto& p : r.solution) {
+            out << " " << p.domino.low << " " << p.domino.high << " " << p.row << " " << p.col
+                << " " << p.horizontal << " " << p.flipped;
+        }
+        out << "\n";
+    }
+
+    static bool read_puzzle(istream& in, PuzzleResult& r) {
+        size_t n = 0;
+        in >> r.name >> r.rows >> r.cols >> n;
+        r.dominoes.resize(in ? n : 0);
+        for (auto& d : r.dominoes) in >> d.low >> d.high;
+        in >> n;
+        r.regions.resize(in ? n : 0);
+        for (auto& region : r.regions) {
+            int type = 0;
+            size_t cells = 0;
+            in >> region.id >> type >> region.target_value >> region.linked_region_id >> cells;
+            if (!in || type < 0 || type >= NUM_CONSTRAINT_TYPES) return false;
+            region.type = (ConstraintType)type;
+            region.cells.resize(cells);
+            for (auto& c : region.cells) in >> c.first >> c.second;
+        }
+        in >> n;
+        r.solution.resize(in ? n : 0);
+        for (auto& p : r.solution) {
+            in >> p.domino.low >> p.domino.high >> p.row >> p.col >> p.horizontal >> p.flipped;
+        }
+        return (bool)in;
+    }
+};
+
+// Combine the reports of every shard of one run, in shard order: counters
+// are summed and each search keeps its lowest-rank result, which is the
+// one a single host searching every rank would have kept. Daily mode packs
+// the pooled candidates. Returns the process exit code.
+int run_merge(const vector<string>& files) {
+    vector<ShardReport> reports(files.size());
+    for (size_t i = 0; i < files.size(); i++) {
+        if (!reports[i].load(files[i])) {
+            cout << files[i] << ": not a readable shard report" << endl;
+            return 1;
+        }
+    }
+    if (reports.empty()) {
+        cout << "merge needs the shard reports to combine" << endl;
+        return 1;
+    }
+    sort(reports.begin(), reports.end(), [](const ShardReport& a, const ShardReport& b) {
+        return a.index < b.index;
+    });
+    const ShardReport& first = reports[0];
+    for (size_t i = 0; i < reports.size(); i++) {
+        const ShardReport& r = reports[i];
+        if (r.count != first.count || r.mode != first.mode || r.exclude != first.exclude) {
+            cout << "Shard " << r.index << " of " << r.count << " (" << r.mode
+                 << ") is from a different run than shard " << first.index << " of "
+                 << first.count << " (" << first.mode << ")" << endl;
+            return 1;
+        }
+        if (i && reports[i - 1].index == r.index) {
+            cout << "Shard " << r.index << " of " << r.count << " is repeated" << endl;
+            return 1;
+        }
+        if (r.index != i) {
+            cout << "Shard " << i << " of " << r.count << " is missing" << endl;
+            return 1;
+        }
+    }
+    if (reports.size() != first.count) {
+        cout << "Shard " << reports.size() << " of " << first.count << " is missing" << endl;
+        return 1;
+    }
+
+    ShardReport merged;
+    merged.has_telemetry = true;
+    for (const auto& r : reports) {
+        merged.attempts += r.attempts;
+        merged.unique += r.unique;
+        merged.collected += r.collected;
+        for (int i = 0; i < NUM_REJECTIONS; i++) merged.rejected[i] += r.rejected[i];
+        merged.has_telemetry = merged.has_telemetry && r.has_telemetry;
+        merged.nodes += r.nodes;
+        merged.dead_ends += r.dead_ends;
+        for (size_t i = 0; i < r.pruned.size(); i++) merged.pruned[i] += r.pruned[i];
+        for (const auto& [tag, ranked] : r.results) {
+            auto it = merged.results.find(tag);
+            if (it == merged.results.end() || ranked.first < it->second.first) {
+                merged.results[tag] = ranked;
             }
+        }
+    }
+
+    cout << "Merged " << first.count << " shards of " << first.mode << endl;
+    if (!first.exclude.empty()) {
+        cout << "Excluding: ";
+        for (const auto& d : first.exclude) cout << d.str() << " ";
+        cout << endl;
+    }
+
+    const char* tags[] = {"easy1", "easy2", "medium", "hard", "random"};
+    const char* labels[] = {"Easy1", "Easy2", "Medium", "Hard"};
+    const char* titles[] = {"EASY PUZZLE 1", "EASY PUZZLE 2", "MEDIUM PUZZLE", "HARD PUZZLE",
+                            "RANDOM PUZZLE"};
+    array<optional<PuzzleResult>, 5> found;
+    for (int t = 0; t < 5; t++) {
+        auto it = merged.results.find(tags[t]);
+        if (it == merged.results.end()) continue;
+        found[t] = it->second.second;
+        const char* title = first.mode == "refine" ? "REFINED PUZZLE" : titles[t];
+        cout << "\n" << title << " from rank " << it->second.first << endl;
+        print_result(title, found[t]);
+    }
 
-            // Center content in cell
-            int pad_left = (cell_width - content.length()) / 2;
-            int pad_right = cell_width - content.length() - pad_left;
-            cout << string(pad_left, ' ') << content << string(pad_right, ' ');
+    if (first.mode == "daily") {
+        candidates.limit = SIZE_MAX;
+        for (const auto& r : reports) {
+            for (int d = 0; d < NUM_DIFFICULTIES; d++) {
+                for (const auto& result : r.candidates[d]) candidates.add((Difficulty)d, result);
+            }
         }
-        cout << "|" << endl;
+        auto& lists = candidates.sorted();
+        vector<int> chosen = pack_disjoint(lists);
+        for (int d = 0; d < NUM_DIFFICULTIES; d++) {
+            cout << "Candidates for " << titles[d] << ": " << lists[d].size() << endl;
+            if (chosen[d] >= 0) found[d] = lists[d][chosen[d]];
+        }
+        for (int d = 0; d < NUM_DIFFICULTIES; d++) print_result(titles[d], found[d]);
+    }
 
-        // Horizontal line between rows
-        cout << "  ";
-        for (int c = 0; c < cols; c++) {
-            Cell above = {r, c};
-            Cell below = {r + 1, c};
-            bool thick = (r == rows - 1) ||
-                (cell_region.count(below) && cell_region[above] != cell_region[below]);
+    uint64_t rejected = 0;
+    for (uint64_t r : merged.rejected) rejected += r;
+    cout << "\n==================================================" << endl;
+    cout << "MERGED SUMMARY (" << first.count << " shards)" << endl;
+    cout << "Total attempts: " << merged.attempts << endl;
+    cout << "Pre-filter rejected: " << rejected
+         << " (sum range " << merged.rejected[(int)Rejection::SUM_RANGE]
+         << ", pip multiset " << merged.rejected[(int)Rejection::PIP_MULTISET]
+         << ", ordering " << merged.rejected[(int)Rejection::ORDERING]
+         << ", total " << merged.rejected[(int)Rejection::TOTAL] << ")" << endl;
+    cout << "Solver calls: " << merged.attempts - rejected << endl;
+    if (merged.has_telemetry) {
+        cout << "Search tree: " << merged.nodes << " nodes, " << merged.dead_ends
+             << " dead ends; pruned";
+        for (int i = 0; i <= NUM_CONSTRAINT_TYPES; i++) {
+            cout << (i ? ", " : " ") << PRUNE_REASONS[i] << " " << merged.pruned[i];
+        }
+        cout << endl;
+    }
+    cout << "==================================================" << endl;
 
-            cout << "+" << (thick ? h_line : h_line);
+    if (merged.collected) {
+        cout << "Collected: " << merged.collected << " puzzles across the shards' collect files" << endl;
+        return 0;
+    }
+    if (first.mode == "daily") {
+        int packed = 0;
+        for (int d = 0; d < NUM_DIFFICULTIES; d++) packed += !!found[d];
+        cout << "Daily set: " << packed << " of " << NUM_DIFFICULTIES
+             << " difficulties with disjoint dominoes" << endl;
+    } else if (first.mode == "random" || first.mode == "refine") {
+        cout << (first.mode == "random" ? "Random: " : "Refined: ") << merged.unique << " unique" << endl;
+    } else {
+        for (int t = 0; t < NUM_DIFFICULTIES; t++) {
+            if (first.mode == tags[t]) {
+                cout << labels[t] << ": " << (found[t] ? "FOUND" : "NOT FOUND") << endl;
+            }
         }
-        cout << "+" << endl;
     }
+    return 0;
 }
 
-void print_result(const string& name, const optional<PuzzleResult>& result) {
-    if (!result) {
-        cout << name << ": NOT FOUND" << endl;
-        return;
-    }
+// "1h02m", "4m05s" or "12s"
+string format_duration(double seconds) {
+    long s = (long)seconds;
+    char text[32];
+    if (s >= 3600) snprintf(text, sizeof(text), "%ldh%02ldm", s / 3600, s / 60 % 60);
+    else if (s >= 60) snprintf(text, sizeof(text), "%ldm%02lds", s / 60, s % 60);
+    else snprintf(text, sizeof(text), "%lds", s);
+    return text;
+}
 
-    cout << "\n" << string(50, '=') << endl;
-    cout << name << ": FOUND!" << endl;
-    cout << string(50, '=') << endl;
+// Periodic view of a running search built from the telemetry counters:
+// throughput since the last report, worker utilization, and an ETA per
+// search phase from the ranks it has finished. Each report can also be
+// written as a Prometheus text file, swapped in by rename so a scraper
+// never reads half of one.
+class ProgressReporter {
+public:
+    ProgressReporter(const ThreadPool& pool, bool print, const string& metrics_path)
+        : pool(pool), print(print), metrics_path(metrics_path),
+          start(chrono::steady_clock::now()), last(start), last_busy(pool.size(), 0) {}
+
+    void report() {
+        auto now = chrono::steady_clock::now();
+        double elapsed = chrono::duration<double>(now - start).count();
+        double dt = max(1e-9, chrono::duration<double>(now - last).count());
+        uint64_t attempts = total_attempts.load(), nodes = telemetry.nodes.load();
+
+        vector<double> busy(pool.size());
+        for (int w = 0; w < pool.size(); w++) busy[w] = pool.busy_seconds(w);
+
+        struct PhaseView {
+            string name;
+            uint64_t done, total;
+            double eta;   // Negative until the phase has a rate
+        };
+        vector<PhaseView> phases;
+        telemetry.for_each_phase([&](const Telemetry::Phase& p) {
+            uint64_t done = p.done.load();
+            double secs = chrono::duration<double>(now - p.start).count();
+            double eta = -1;
+            if (done > p.start_done && secs > 0) {
+                eta = (p.total - done) * secs / (done - p.start_done);
+            }
+            phases.push_back({p.name, done, p.total, eta});
+        });
+
+        if (print) {
+            ostringstream line;
+            line.precision(3);
+            line << "[Progress " << format_duration(elapsed) << "] attempts " << attempts << " ("
+                 << (attempts - last_attempts) / dt << "/s), nodes " << (double)nodes << " ("
+                 << (nodes - last_nodes) / dt << "/s), util";
+            for (int w = 0; w < pool.size(); w++) {
+                line << " " << (int)(100 * min(1.0, (busy[w] - last_busy[w]) / dt)) << "%";
+            }
+            for (const auto& p : phases) {
+                line << " | " << p.name << " " << 100.0 * p.done / max<uint64_t>(1, p.total) << "%";
+                if (p.eta >= 0) line << " ETA " << format_duration(p.eta);
+            }
+            lock_guard<mutex> lock(console_mutex);
+            cout << line.str() << endl;
+        }
 
-    cout << "Grid: " << result->rows << "x" << result->cols << endl;
-    cout << "Dominoes: ";
-    for (const auto& d : result->dominoes) {
-        cout << d.str() << " ";
-    }
-    cout << endl << endl;
+        if (!metrics_path.empty()) {
+            ostringstream out;
+            auto metric = [&out](const char* name, const char* type, const char* help) {
+                out << "# HELP puzzle_gen_" << name << " " << help << "\n"
+                    << "# TYPE puzzle_gen_" << name << " " << type << "\n";
+            };
+            metric("uptime_seconds", "gauge", "Seconds since the searches started.");
+            out << "puzzle_gen_uptime_seconds " << elapsed << "\n";
+            metric("attempts_total", "counter", "Puzzle configurations tried.");
+            out << "puzzle_gen_attempts_total " << attempts << "\n";
+            metric("nodes_total", "counter", "Dominoes placed by the solvers.");
+            out << "puzzle_gen_nodes_total " << nodes << "\n";
+            metric("dead_ends_total", "counter", "Cells no placement survived on.");
+            out << "puzzle_gen_dead_ends_total " << telemetry.dead_ends.load() << "\n";
+            metric("pruned_total", "counter", "Placements rejected, by the check that failed.");
+            for (int i = 0; i <= NUM_CONSTRAINT_TYPES; i++) {
+                out << "puzzle_gen_pruned_total{reason=\"" << PRUNE_REASONS[i] << "\"} "
+                    << telemetry.pruned[i].load() << "\n";
+            }
+            metric("tt_probes_total", "counter", "Transposition table lookups by the backtracking solver.");
+            out << "puzzle_gen_tt_probes_total " << telemetry.tt_probes.load() << "\n";
+            metric("tt_hits_total", "counter", "Lookups that settled a subproblem without searching it.");
+            out << "puzzle_gen_tt_hits_total " << telemetry.tt_hits.load() << "\n";
+            metric("worker_busy_seconds_total", "counter", "Time each worker spent running tasks.");
+            for (int w = 0; w < pool.size(); w++) {
+                out << "puzzle_gen_worker_busy_seconds_total{worker=\"" << w << "\"} " << busy[w] << "\n";
+            }
+            metric("phase_ranks_done", "gauge", "Combination ranks a search phase has finished.");
+            for (const auto& p : phases) {
+                out << "puzzle_gen_phase_ranks_done{phase=\"" << p.name << "\"} " << p.done << "\n";
+            }
+            metric("phase_ranks_total", "gauge", "Combination ranks in a search phase.");
+            for (const auto& p : phases) {
+                out << "puzzle_gen_phase_ranks_total{phase=\"" << p.name << "\"} " << p.total << "\n";
+            }
+            metric("phase_eta_seconds", "gauge", "Estimated seconds until a search phase finishes.");
+            for (const auto& p : phases) {
+                if (p.eta >= 0) out << "puzzle_gen_phase_eta_seconds{phase=\"" << p.name << "\"} " << p.eta << "\n";
+            }
+            string tmp = metrics_path + ".tmp";
+            ofstream(tmp, ios::trunc) << out.str();
+            rename(tmp.c_str(), metrics_path.c_str());
+        }
 
-    // Draw puzzle grid
-    cout << "PUZZLE:" << endl;
-    draw_puzzle_grid(*result);
+        last = now;
+        last_attempts = attempts;
+        last_nodes = nodes;
+        last_busy = busy;
+    }
 
-    // Draw solution with domino boundaries
-    cout << endl << "SOLUTION:" << endl;
-    int rows = result->rows;
-    int cols = result->cols;
-    int cell_width = 5;
-    string h_line(cell_width, '-');
-    string h_space(cell_width, ' ');
+private:
+    const ThreadPool& pool;
+    bool print;
+    string metrics_path;
+    chrono::steady_clock::time_point start, last;
+    uint64_t last_attempts = 0, last_nodes = 0;
+    vector<double> last_busy;
+};
 
-    // Build cell-to-pip and cell-to-domino maps
-    map<Cell, int> cell_pip;
-    map<Cell, int> cell_domino;  // Which domino each cell belongs to
-    for (size_t i = 0; i < result->solution.size(); i++) {
-        const auto& p = result->solution[i];
-        Cell c1 = p.cell1();
-        Cell c2 = p.cell2();
-        cell_pip[c1] = p.domino.low;
-        cell_pip[c2] = p.domino.high;
-        cell_domino[c1] = i;
-        cell_domino[c2] = i;
+// Dominoes i-j with i <= j <= max_pip, keeping only those whose high end
+// exceeds skip_upto (so max_pip 9, skip_upto 6 gives the d9 remainder)
+vector<Domino> make_dominoes(int max_pip, int skip_upto = -1) {
+    vector<Domino> set;
+    for (int i = 0; i <= max_pip; i++) {
+        for (int j = i; j <= max_pip; j++) {
+            if (j > skip_upto) set.push_back({i, j});
+        }
     }
+    return set;
+}
 
-    // Top border
-    cout << "  ";
-    for (int c = 0; c < cols; c++) cout << "+" << h_line;
-    cout << "+" << endl;
-
-    for (int r = 0; r < rows; r++) {
-        // Content row
-        cout << "  ";
-        for (int c = 0; c < cols; c++) {
-            Cell cell = {r, c};
-            Cell left = {r, c - 1};
+// One solve in the benchmark corpus
+struct BenchCase {
+    vector<Domino> dominoes;
+    vector<Region> regions;
+    int rows, cols;
+    bool sweep;
+};
 
-            // Vertical border: show if edge or different domino
-            bool show_border = (c == 0) || !cell_domino.count(left) ||
-                              cell_domino[left] != cell_domino[cell];
-            cout << (show_border ? "|" : " ");
+// Throughput and latency of one corpus group
+struct BenchStats {
+    uint64_t solves = 0, nodes = 0;
+    double solves_per_sec = 0, nodes_per_sec = 0;
+    double p50_us = 0, p99_us = 0;
+};
 
-            string content = cell_pip.count(cell) ? to_string(cell_pip[cell]) : " ";
-            int pad_left = (cell_width - content.length()) / 2;
-            int pad_right = cell_width - content.length() - pad_left;
-            cout << string(pad_left, ' ') << content << string(pad_right, ' ');
+// Fixed, deterministic corpus: evenly spaced domino sets on each of the
+// four search layouts (solved as the searches solve them), the bundled
+// NYT puzzles, and seeded random layouts
+vector<pair<string, vector<BenchCase>>> bench_corpus() {
+    vector<pair<string, vector<BenchCase>>> corpus;
+    vector<Domino> all_d6 = make_dominoes(6), d9_remainder = make_dominoes(9, 6);
+
+    // Sets the pre-filter would reject never reach the solver in a
+    // search, so they are passed over here too
+    auto layout_group = [&](const string& name, const Layout& layout, const vector<Domino>& pool,
+                            int k, uint64_t count) {
+        vector<BenchCase> cases;
+        CombinationSpace combos(pool, k);
+        vector<int> idx;
+        vector<Domino> dominoes;
+        uint64_t step = max<uint64_t>(1, combos.size() / (count * 16));
+        uint64_t sets = 0;
+        for (uint64_t rank = 0; rank < combos.size() && sets < count; rank += step) {
+            combos.unrank(rank, idx);
+            combos.materialize(idx, dominoes);
+            BenchCase c{dominoes, layout.regions, layout.rows, layout.cols, true};
+            size_t before = cases.size();
+            // Medium fixes its last target instead of sweeping it
+            if (name == "medium") {
+                int max_sum = 0;
+                for (const auto& d : dominoes) max_sum = max(max_sum, d.pips());
+                c.regions.back().target_value = max_sum;
+                c.sweep = false;
+            }
+            // Hard solves each target in turn
+            if (name == "hard") {
+                int total = 0;
+                for (const auto& d : dominoes) total += d.pips();
+                c.sweep = false;
+                for (int target = 1; target < total; target++) {
+                    c.regions.back().target_value = target;
+                    if (prefilter(c.dominoes, c.regions) == Rejection::NONE) cases.push_back(c);
+                }
+            } else if (prefilter(c.dominoes, c.regions) == Rejection::NONE) {
+                cases.push_back(move(c));
+            }
+            if (cases.size() > before) sets++;
         }
-        cout << "|" << endl;
+        corpus.push_back({name, move(cases)});
+    };
+    layout_group("easy1", easy1_layout(), all_d6, 4, 512);
+    layout_group("easy2", easy2_layout(), all_d6, 4, 512);
+    layout_group("medium", medium_layout(), all_d6, 6, 256);
+    layout_group("hard", hard_layout(), d9_remainder, 8, 16);
+
+    // Each puzzle repeated so the percentiles mean something
+    vector<BenchCase> nyt;
+    for (const char* path : {"nyt_2026-01-06.json", "nyt_2026-01-08.json"}) {
+        vector<NytPuzzle> puzzles;
+        if (!load_nyt_file(path, puzzles)) {
+            cout << "Bench: " << path << " not found, leaving it out" << endl;
+            continue;
+        }
+        for (const auto& p : puzzles) {
+            if (!p.unsupported.empty()) continue;
+            for (int r = 0; r < 16; r++) nyt.push_back({p.dominoes, p.regions, p.rows, p.cols, false});
+        }
+    }
+    if (!nyt.empty()) corpus.push_back({"nyt", move(nyt)});
+
+    vector<BenchCase> random;
+    for (uint64_t i = 0; random.size() < 256; i++) {
+        Rng rng(12345, i);
+        BenchCase c{{}, {}, 0, 0, false};
+        if (random_puzzle(rng, all_d6, 8, 6, c.dominoes, c.regions, c.rows, c.cols)) {
+            random.push_back(move(c));
+        }
+    }
+    corpus.push_back({"random", move(random)});
+    return corpus;
+}
 
-        // Horizontal line: show segment if edge or different domino from below
-        cout << "  ";
-        for (int c = 0; c < cols; c++) {
-            Cell above = {r, c};
-            Cell below = {r + 1, c};
+BenchStats run_bench_group(const vector<BenchCase>& cases) {
+    BenchStats stats;
+    vector<double> latencies;
+    latencies.reserve(cases.size());
+    double total_us = 0;
+    for (const auto& c : cases) {
+        Solver solver(c.dominoes, c.regions, c.rows, c.cols, 2);
+        solver.sweep = c.sweep;
+        auto t0 = chrono::steady_clock::now();
+        solve_with(solver, search_engine);
+        double us = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count();
+        latencies.push_back(us);
+        total_us += us;
+        stats.nodes += solver.stats.nodes;
+    }
+    stats.solves = cases.size();
+    sort(latencies.begin(), latencies.end());
+    if (!latencies.empty()) {
+        stats.p50_us = latencies[latencies.size() / 2];
+        stats.p99_us = latencies[min(latencies.size() - 1, latencies.size() * 99 / 100)];
+    }
+    if (total_us > 0) {
+        stats.solves_per_sec = stats.solves * 1e6 / total_us;
+        stats.nodes_per_sec = stats.nodes * 1e6 / total_us;
+    }
+    return stats;
+}
 
-            bool show_h_border = (r == rows - 1) || !cell_domino.count(below) ||
-                                 cell_domino[above] != cell_domino[below];
-            cout << "+" << (show_h_border ? h_line : h_space);
+// Run the corpus single-threaded, so timings are comparable between runs,
+// and check it against a baseline written by an earlier --save-baseline.
+// A group is a regression when its solves/sec falls more than tolerance
+// percent below the baseline. Returns the process exit code.
+int run_bench(const string& baseline_path, const string& save_path, double tolerance) {
+    map<string, BenchStats> baseline;
+    if (!baseline_path.empty()) {
+        ifstream in(baseline_path);
+        if (!in) {
+            cout << "Cannot read baseline " << baseline_path << endl;
+            return 1;
+        }
+        string line;
+        while (getline(in, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            istringstream fields(line);
+            string group;
+            BenchStats s;
+            if (fields >> group >> s.solves >> s.nodes >> s.solves_per_sec >> s.nodes_per_sec
+                       >> s.p50_us >> s.p99_us) {
+                baseline[group] = s;
+            }
         }
-        cout << "+" << endl;
     }
 
-    // Output Python code
-    cout << endl << "Python code for puzzles.py:" << endl;
-    cout << "  dominoes = [";
-    for (size_t i = 0; i < result->dominoes.size(); i++) {
-        if (i > 0) cout << ", ";
-        cout << "Domino(" << result->dominoes[i].low << ", " << result->dominoes[i].high << ")";
+    cout << "Benchmark (engine " << engine_name(search_engine) << ")" << endl;
+    printf("%-8s %7s %12s %12s %12s %10s %10s\n", "group", "solves", "nodes",
+           "solves/s", "nodes/s", "p50 us", "p99 us");
+    ostringstream saved;
+    saved << "# group solves nodes solves_per_sec nodes_per_sec p50_us p99_us" << endl;
+    int regressions = 0;
+    for (const auto& [group, cases] : bench_corpus()) {
+        BenchStats s = run_bench_group(cases);
+        printf("%-8s %7llu %12llu %12.1f %12.0f %10.1f %10.1f", group.c_str(),
+               (unsigned long long)s.solves, (unsigned long long)s.nodes,
+               s.solves_per_sec, s.nodes_per_sec, s.p50_us, s.p99_us);
+        auto it = baseline.find(group);
+        if (it != baseline.end() && it->second.solves_per_sec > 0) {
+            double change = 100.0 * (s.solves_per_sec / it->second.solves_per_sec - 1);
+            printf("  %+6.1f%%", change);
+            if (change < -tolerance) {
+                printf("  REGRESSION");
+                regressions++;
+            }
+            // The corpus is fixed, so a node count change means the search itself changed
+            if (s.nodes != it->second.nodes) {
+                printf("  (nodes were %llu)", (unsigned long long)it->second.nodes);
+            }
+        }
+        printf("\n");
+        saved << group << " " << s.solves << " " << s.nodes << " " << s.solves_per_sec << " "
+              << s.nodes_per_sec << " " << s.p50_us << " " << s.p99_us << endl;
     }
-    cout << "]" << endl;
-
-    cout << "  regions = [" << endl;
-    for (const auto& r : result->regions) {
-        cout << "    Region(" << r.id << ", [";
-        for (size_t i = 0; i < r.cells.size(); i++) {
-            if (i > 0) cout << ", ";
-            cout << "(" << r.cells[i].first << ", " << r.cells[i].second << ")";
+    fflush(stdout);
+
+    if (!save_path.empty()) {
+        ofstream out(save_path, ios::trunc);
+        out << saved.str();
+        if (!out) {
+            cout << "Cannot write baseline " << save_path << endl;
+            return 1;
         }
-        cout << "], ConstraintType.";
-        if (r.type == ConstraintType::SUM) cout << "SUM, target_value=" << r.target_value;
-        else if (r.type == ConstraintType::LESS) cout << "LESS, linked_region_id=" << r.linked_region_id;
-        else if (r.type == ConstraintType::EQUAL) cout << "EQUAL";
-        else if (r.type == ConstraintType::GREATER) cout << "GREATER, linked_region_id=" << r.linked_region_id;
-        cout << ")," << endl;
+        cout << "Baseline saved to " << save_path << endl;
     }
-    cout << "  ]" << endl;
+    if (!baseline.empty()) {
+        cout << regressions << " regression(s) beyond " << tolerance << "% against "
+             << baseline_path << endl;
+    }
+    return regressions ? 1 : 0;
 }
 
-void print_usage() {
-    cout << "Usage: puzzle_gen [mode]" << endl;
-    cout << "Modes:" << endl;
-    cout << "  easy        - Generate Easy1 + Easy2 (Easy2 from remainder after Easy1)" << endl;
-    cout << "  medium-hard - Generate Medium + Hard (Hard from remainder after Medium)" << endl;
-    cout << "  easy1       - Generate Easy1 only" << endl;
-    cout << "  easy2 [d1] [d2] [d3] [d4] - Generate Easy2 excluding specified dominoes" << endl;
-    cout << "  medium      - Generate Medium only" << endl;
-    cout << "  hard [d1] ... [d6] - Generate Hard excluding specified dominoes" << endl;
-    cout << "  all         - Generate all puzzles (default)" << endl;
-    cout << "\nDomino format: low-high (e.g., 0-0, 1-2, 3-6)" << endl;
+// Attempts a search makes over ranks [0, n) on a single worker, which
+// takes its chunks lowest first, leaving the winning rank in found.rank
+uint64_t run_search(Found& found, optional<PuzzleResult>& result, const CombinationSpace& combos,
+                    void (*search)(int, const CombinationSpace&, uint64_t, uint64_t), uint64_t n) {
+    found.set = false;
+    found.rank = UINT64_MAX;
+    result.reset();
+    total_attempts.store(0);
+    ThreadPool pool(1);
+    parallel_for(pool, n, [&](int worker, uint64_t begin, uint64_t end) {
+        search(worker, combos, begin, end);
+    });
+    return total_attempts.load();
 }
 
-vector<Domino> exclude_dominoes(const vector<Domino>& pool, const vector<Domino>& exclude) {
-    vector<Domino> result;
-    for (const auto& d : pool) {
-        bool found = false;
-        for (const auto& e : exclude) {
-            if (d == e) { found = true; break; }
-        }
-        if (!found) result.push_back(d);
+// Run Easy2 and Medium unsharded and as --shard 0/1, and again over just
+// the ranks up to the winner. Both full runs must find the same rank and,
+// visiting ranks in order, stop within twice the attempts of that prefix;
+// more means ranks past the best hit are no longer being cut off.
+// Returns the process exit code.
+int run_shard_check() {
+    vector<Domino> all_d6 = make_dominoes(6);
+    CombinationSpace easy_combos(all_d6, 4), medium_combos(all_d6, 6);
+    struct Check {
+        const char* name;
+        Found& found;
+        optional<PuzzleResult>& result;
+        const CombinationSpace& combos;
+        void (*search)(int, const CombinationSpace&, uint64_t, uint64_t);
+    };
+    Check checks[] = {
+        {"easy2", found_easy2, easy2_result, easy_combos, search_easy_3cell_regions},
+        {"medium", found_medium, medium_result, medium_combos, search_medium},
+    };
+
+    struct Row {
+        uint64_t rank, sharded_rank, prefix, unsharded, sharded;
+    };
+    vector<Row> rows;
+    for (const auto& c : checks) {
+        Row row;
+        shard = ShardRange{};
+        row.unsharded = run_search(c.found, c.result, c.combos, c.search, c.combos.size());
+        row.rank = c.found.rank.load();
+        shard = ShardRange{0, 1, true};
+        row.sharded = run_search(c.found, c.result, c.combos, c.search, c.combos.size());
+        row.sharded_rank = c.found.rank.load();
+        shard = ShardRange{};
+        row.prefix = row.rank < c.combos.size()
+            ? run_search(c.found, c.result, c.combos, c.search, row.rank + 1) : row.unsharded;
+        rows.push_back(row);
     }
-    return result;
-}
 
-Domino parse_domino(const string& s) {
-    size_t dash = s.find('-');
-    if (dash == string::npos) return {-1, -1};
-    int low = stoi(s.substr(0, dash));
-    int high = stoi(s.substr(dash + 1));
-    if (low > high) swap(low, high);
-    return {low, high};
+    printf("\n%-8s %10s %10s %12s %12s\n", "search", "rank", "prefix", "attempts", "shard 0/1");
+    int failures = 0;
+    for (size_t i = 0; i < rows.size(); i++) {
+        const Row& r = rows[i];
+        printf("%-8s %10llu %10llu %12llu %12llu", checks[i].name, (unsigned long long)r.rank,
+               (unsigned long long)r.prefix, (unsigned long long)r.unsharded,
+               (unsigned long long)r.sharded);
+        if (r.sharded_rank != r.rank) {
+            printf("  FAILED (sharded run found rank %llu)", (unsigned long long)r.sharded_rank);
+            failures++;
+        } else if (max(r.unsharded, r.sharded) > 2 * r.prefix) {
+            printf("  FAILED (searched past the winner)");
+            failures++;
+        }
+        printf("\n");
+    }
+    fflush(stdout);
+    return failures ? 1 : 0;
 }
 
+// Left out when the solver is compiled into the Python extension
+#ifndef PUZZLE_GEN_NO_MAIN
 int main(int argc, char* argv[]) {
     string mode = "all";
     vector<Domino> exclude_list;
+    vector<string> input_files;
+    int num_threads = max(1u, thread::hardware_concurrency());
+    uint64_t random_seed = 1, random_samples = 100000;
+    int random_dominoes = 8;
+    bool resume = false;
+    string collect_path;
+    ResultWriter::Format collect_format = ResultWriter::Format::JSONL;
+    int checkpoint_interval = 30;
+    string baseline_path, save_baseline_path;
+    double tolerance = 10;
+    int progress_interval = 0;
+    string metrics_path;
+    size_t daily_candidates = 16;
+    string shard_path;
 
     if (argc > 1) {
         mode = argv[1];
@@ -834,34 +5719,134 @@ int main(int argc, char* argv[]) {
             print_usage();
             return 0;
         }
-        // Parse excluded dominoes
+        // Parse options and excluded dominoes
         for (int i = 2; i < argc; i++) {
-            Domino d = parse_domino(argv[i]);
+            string arg = argv[i];
+            if (arg == "--threads" && i + 1 < argc) {
+                num_threads = max(1, atoi(argv[++i]));
+                continue;
+            }
+            if (arg == "--engine" && i + 1 < argc) {
+                string name = argv[++i];
+                search_engine = name == "dlx"       ? Engine::DLX
+                              : name == "backtrack" ? Engine::BACKTRACK
+                              : name == "tilings"   ? Engine::TILINGS
+                              : name == "sat"       ? Engine::SAT
+                              : Engine::AUTO;
+                continue;
+            }
+            if (arg == "--seed" && i + 1 < argc) {
+                random_seed = strtoull(argv[++i], nullptr, 10);
+                continue;
+            }
+            if (arg == "--samples" && i + 1 < argc) {
+                random_samples = strtoull(argv[++i], nullptr, 10);
+                continue;
+            }
+            if (arg == "--dominoes" && i + 1 < argc) {
+                random_dominoes = min(30, max(2, atoi(argv[++i])));
+                continue;
+            }
+            if (arg == "--checkpoint" && i + 1 < argc) {
+                checkpoint.path = argv[++i];
+                checkpoint.enabled = true;
+                continue;
+            }
+            if (arg == "--checkpoint-interval" && i + 1 < argc) {
+                checkpoint_interval = max(1, atoi(argv[++i]));
+                continue;
+            }
+            if (arg == "--collect" && i + 1 < argc) {
+                collect_path = argv[++i];
+                continue;
+            }
+            if (arg == "--format" && i + 1 < argc) {
+                collect_format = string(argv[++i]) == "binary" ? ResultWriter::Format::BINARY
+                                                                : ResultWriter::Format::JSONL;
+                continue;
+            }
+            if (arg == "--shard" && i + 1 < argc) {
+                unsigned long long k = 0, n = 0;
+                if (sscanf(argv[++i], "%llu/%llu", &k, &n) != 2 || n == 0 || k >= n) {
+                    cout << "--shard wants K/N with 0 <= K < N, e.g. 3/16" << endl;
+                    return 1;
+                }
+                shard = {k, n, true};
+                continue;
+            }
+            if (arg == "--shard-file" && i + 1 < argc) {
+                shard_path = argv[++i];
+                continue;
+            }
+            if (arg == "--candidates" && i + 1 < argc) {
+                daily_candidates = max(1, atoi(argv[++i]));
+                continue;
+            }
+            if (arg == "--baseline" && i + 1 < argc) {
+                baseline_path = argv[++i];
+                continue;
+            }
+            if (arg == "--save-baseline" && i + 1 < argc) {
+                save_baseline_path = argv[++i];
+                continue;
+            }
+            if (arg == "--tolerance" && i + 1 < argc) {
+                tolerance = atof(argv[++i]);
+                continue;
+            }
+            if (arg == "--progress" && i + 1 < argc) {
+                progress_interval = max(1, atoi(argv[++i]));
+                telemetry.enabled = true;
+                continue;
+            }
+            if (arg == "--metrics" && i + 1 < argc) {
+                metrics_path = argv[++i];
+                telemetry.enabled = true;
+                continue;
+            }
+            if (arg == "--resume") {
+                resume = checkpoint.enabled = true;
+                continue;
+            }
+            if (mode == "verify" || mode == "merge") {
+                input_files.push_back(arg);
+                continue;
+            }
+            Domino d = parse_domino(arg);
             if (d.low >= 0) exclude_list.push_back(d);
         }
     }
 
+    // Easy2 and Hard draw from what Easy1 and Medium leave, which a shard
+    // cannot know, so a chain is sharded one search at a time: merge, then
+    // pass the merged puzzle's dominoes to the next search as exclusions
+    bool searches = mode != "verify" && mode != "bench" && mode != "shard-check" && mode != "merge";
+    if (shard.enabled && (!searches || mode == "all" || mode == "easy" || mode == "medium-hard")) {
+        cout << "--shard applies to a single search: easy1, easy2, medium, hard, daily or random"
+             << endl;
+        return 1;
+    }
+    if (shard.enabled && shard_path.empty()) {
+        shard_path = "puzzle_gen." + to_string(shard.index) + "-of-" + to_string(shard.count) +
+                     ".shard";
+    }
+
+    if (mode == "verify") return run_verify(input_files, num_threads);
+    if (mode == "bench") return run_bench(baseline_path, save_baseline_path, tolerance);
+    if (mode == "shard-check") return run_shard_check();
+    if (mode == "merge") return run_merge(input_files);
+
     cout << "==================================================" << endl;
     cout << "MULTITHREADED DOMINO PUZZLE GENERATOR (C++)" << endl;
     cout << "Mode: " << mode << endl;
+    cout << "Threads: " << num_threads << endl;
+    cout << "Engine: " << engine_name(search_engine) << endl;
+    if (shard.enabled) cout << "Shard: " << shard.index << " of " << shard.count << endl;
     cout << "==================================================" << endl;
 
     // Build domino sets
-    vector<Domino> all_d6;
-    for (int i = 0; i <= 6; i++) {
-        for (int j = i; j <= 6; j++) {
-            all_d6.push_back({i, j});
-        }
-    }
-
-    vector<Domino> d9_remainder;
-    for (int i = 0; i <= 9; i++) {
-        for (int j = i; j <= 9; j++) {
-            if (i >= 7 || j >= 7) {
-                d9_remainder.push_back({i, j});
-            }
-        }
-    }
+    vector<Domino> all_d6 = make_dominoes(6);
+    vector<Domino> d9_remainder = make_dominoes(9, 6);
 
     cout << "Double-six set: " << all_d6.size() << " dominoes" << endl;
     cout << "D9 remainder: " << d9_remainder.size() << " dominoes" << endl;
@@ -872,78 +5857,248 @@ int main(int argc, char* argv[]) {
         cout << endl;
     }
 
+    bool do_daily = (mode == "daily");
+    if (do_daily && !collect_path.empty()) {
+        cout << "Daily mode keeps its candidates in memory and cannot --collect" << endl;
+        return 1;
+    }
+    if (do_daily) candidates.limit = daily_candidates;
+
+    if (!collect_path.empty()) {
+        if (!collector.open(collect_path, collect_format, num_threads)) {
+            cout << "Cannot open " << collect_path << " for writing" << endl;
+            return 1;
+        }
+        cout << "Collecting every unique puzzle into " << collect_path << endl;
+    }
+
+    if (resume) {
+        if (checkpoint.load()) {
+            cout << "Resuming from " << checkpoint.path << " (" << total_attempts.load()
+                 << " attempts so far)" << endl;
+        } else {
+            cout << "No usable checkpoint at " << checkpoint.path << ", starting fresh" << endl;
+        }
+    }
+
+    // Periodic checkpoint writer and progress reporter, stopped once the
+    // searches finish
+    mutex writer_mutex;
+    condition_variable writer_wake;
+    bool searches_done = false;
+    thread writer;
+    if (checkpoint.enabled) {
+        writer = thread([&]() {
+            unique_lock<mutex> lock(writer_mutex);
+            while (!writer_wake.wait_for(lock, chrono::seconds(checkpoint_interval),
+                                         [&] { return searches_done; })) {
+                checkpoint.save();
+            }
+        });
+    }
+
     auto start = chrono::high_resolution_clock::now();
-    vector<thread> threads;
+    ThreadPool pool(num_threads);
+
+    ProgressReporter reporter(pool, progress_interval > 0, metrics_path);
+    thread reporter_thread;
+    if (telemetry.enabled) {
+        int interval = progress_interval > 0 ? progress_interval : 10;
+        reporter_thread = thread([&, interval]() {
+            unique_lock<mutex> lock(writer_mutex);
+            while (!writer_wake.wait_for(lock, chrono::seconds(interval),
+                                         [&] { return searches_done; })) {
+                reporter.report();
+            }
+        });
+    }
 
     bool do_easy1 = (mode == "all" || mode == "easy" || mode == "easy1");
     bool do_easy2 = (mode == "all" || mode == "easy" || mode == "easy2");
     bool do_medium = (mode == "all" || mode == "medium-hard" || mode == "medium");
     bool do_hard = (mode == "all" || mode == "medium-hard" || mode == "hard");
-
-    // Easy 1
-    if (do_easy1) {
-        cout << "\nSearching for Easy1..." << endl;
-        for (int i = 0; i < 4; i++) {
-            threads.emplace_back(search_easy_2x4_sums, i, ref(all_d6));
+    bool do_refine = (mode == "refine");
+    bool do_random = (mode == "random" || do_refine);
+
+    auto announce = [](const string& msg) {
+        lock_guard<mutex> lock(console_mutex);
+        cout << msg << endl;
+    };
+
+    // A search keeps lowering its result until it ends, so the winner is
+    // shown once its whole phase is done
+    auto show = [](const string& name, const optional<PuzzleResult>& result) {
+        if (!result) return;
+        lock_guard<mutex> lock(console_mutex);
+        print_result(name, result);
+        cout << flush;
+    };
+
+    // Easy2's pool depends on Easy1's result and Hard's on Medium's, so the
+    // two chains run side by side, sharing the pool.
+    auto easy_chain = [&]() {
+        // Easy 1
+        if (do_easy1) {
+            announce("\nSearching for Easy1...");
+            CombinationSpace combos(all_d6, 4);
+            parallel_for(pool, combos.size(), [&](int worker, uint64_t begin, uint64_t end) {
+                search_easy_2x4_sums(worker, combos, begin, end);
+            }, combos.fingerprint("easy1"), "easy1", &found_easy1, &easy1_result);
+            show("EASY PUZZLE 1", easy1_result);
         }
-        for (auto& t : threads) t.join();
-        threads.clear();
-    }
 
-    // Easy 2 - use remainder after Easy1
-    if (do_easy2) {
-        vector<Domino> easy2_pool = all_d6;
+        // Easy 2 - use remainder after Easy1
+        if (do_easy2) {
+            vector<Domino> easy2_pool = all_d6;
+
+            // Exclude Easy1 dominoes if we found them
+            if (easy1_result) {
+                easy2_pool = exclude_dominoes(all_d6, easy1_result->dominoes);
+                announce("\nSearching for Easy2 (excluding Easy1 dominoes: " +
+                         to_string(easy2_pool.size()) + " remaining)...");
+            } else if (!exclude_list.empty()) {
+                easy2_pool = exclude_dominoes(all_d6, exclude_list);
+                announce("\nSearching for Easy2 (excluding specified dominoes: " +
+                         to_string(easy2_pool.size()) + " remaining)...");
+            } else {
+                announce("\nSearching for Easy2...");
+            }
 
-        // Exclude Easy1 dominoes if we found them
-        if (easy1_result) {
-            easy2_pool = exclude_dominoes(all_d6, easy1_result->dominoes);
-            cout << "\nSearching for Easy2 (excluding Easy1 dominoes: " << easy2_pool.size() << " remaining)..." << endl;
-        } else if (!exclude_list.empty()) {
-            easy2_pool = exclude_dominoes(all_d6, exclude_list);
-            cout << "\nSearching for Easy2 (excluding specified dominoes: " << easy2_pool.size() << " remaining)..." << endl;
-        } else {
-            cout << "\nSearching for Easy2..." << endl;
+            CombinationSpace combos(easy2_pool, 4);
+            parallel_for(pool, combos.size(), [&](int worker, uint64_t begin, uint64_t end) {
+                search_easy_3cell_regions(worker, combos, begin, end);
+            }, combos.fingerprint("easy2"), "easy2", &found_easy2, &easy2_result);
+            show("EASY PUZZLE 2", easy2_result);
         }
-
-        for (int i = 0; i < 4; i++) {
-            threads.emplace_back(search_easy_3cell_regions, i, ref(easy2_pool));
+    };
+
+    auto medium_hard_chain = [&]() {
+        // Medium
+        if (do_medium) {
+            announce("\nSearching for Medium...");
+            CombinationSpace combos(all_d6, 6);
+            parallel_for(pool, combos.size(), [&](int worker, uint64_t begin, uint64_t end) {
+                search_medium(worker, combos, begin, end);
+            }, combos.fingerprint("medium"), "medium", &found_medium, &medium_result);
+            show("MEDIUM PUZZLE", medium_result);
         }
-        for (auto& t : threads) t.join();
-        threads.clear();
-    }
 
-    // Medium
-    if (do_medium) {
-        cout << "\nSearching for Medium..." << endl;
-        for (int i = 0; i < 4; i++) {
-            threads.emplace_back(search_medium, i, ref(all_d6));
-        }
-        for (auto& t : threads) t.join();
-        threads.clear();
-    }
+        // Hard - use d9_remainder + unused d6
+        if (do_hard) {
+            vector<Domino> hard_pool = d9_remainder;
 
-    // Hard - use d9_remainder + unused d6
-    if (do_hard) {
-        vector<Domino> hard_pool = d9_remainder;
+            // Add unused d6 dominoes (those not used by medium)
+            vector<Domino> unused_d6 = all_d6;
+            if (medium_result) {
+                unused_d6 = exclude_dominoes(all_d6, medium_result->dominoes);
+            } else if (!exclude_list.empty()) {
+                unused_d6 = exclude_dominoes(all_d6, exclude_list);
+            }
 
-        // Add unused d6 dominoes (those not used by medium)
-        vector<Domino> unused_d6 = all_d6;
-        if (medium_result) {
-            unused_d6 = exclude_dominoes(all_d6, medium_result->dominoes);
-        } else if (!exclude_list.empty()) {
-            unused_d6 = exclude_dominoes(all_d6, exclude_list);
-        }
+            // Combine d9_remainder with unused d6
+            for (const auto& d : unused_d6) {
+                hard_pool.push_back(d);
+            }
 
-        // Combine d9_remainder with unused d6
-        for (const auto& d : unused_d6) {
-            hard_pool.push_back(d);
+            announce("\nSearching for Hard (d9_remainder + unused d6: " +
+                     to_string(hard_pool.size()) + " dominoes)...");
+            CombinationSpace combos(hard_pool, 8);
+            parallel_for(pool, combos.size(), [&](int worker, uint64_t begin, uint64_t end) {
+                search_hard(worker, combos, begin, end);
+            }, combos.fingerprint("hard"), "hard", &found_hard, &hard_result);
+            show("HARD PUZZLE", hard_result);
         }
-
-        cout << "\nSearching for Hard (d9_remainder + unused d6: " << hard_pool.size() << " dominoes)..." << endl;
-        for (int i = 0; i < 4; i++) {
-            threads.emplace_back(search_hard, i, ref(d9_remainder), ref(unused_d6));
+    };
+
+    // All four searches at once, each over the pool it would draw from
+    // with nothing found yet, gathering candidates for pack_disjoint()
+    // instead of stopping at the first. Candidates live only in memory,
+    // so the searches are not checkpointed.
+    auto daily_searches = [&]() {
+        vector<Domino> d6_pool = exclude_dominoes(all_d6, exclude_list);
+        vector<Domino> hard_pool = exclude_dominoes(d9_remainder, exclude_list);
+        hard_pool.insert(hard_pool.end(), d6_pool.begin(), d6_pool.end());
+        CombinationSpace easy_combos(d6_pool, 4), medium_combos(d6_pool, 6);
+        CombinationSpace hard_combos(hard_pool, 8);
+        announce("\nSearching all difficulties for up to " + to_string(candidates.limit) +
+                 " candidates each (" + to_string(d6_pool.size()) + " double-six, " +
+                 to_string(hard_pool.size()) + " hard pool dominoes)...");
+
+        JointScheduler scheduler;
+        scheduler.add("easy1", easy_combos.size(), [&](int worker, uint64_t begin, uint64_t end) {
+            search_easy_2x4_sums(worker, easy_combos, begin, end);
+        }, found_easy1.set);
+        scheduler.add("easy2", easy_combos.size(), [&](int worker, uint64_t begin, uint64_t end) {
+            search_easy_3cell_regions(worker, easy_combos, begin, end);
+        }, found_easy2.set);
+        scheduler.add("medium", medium_combos.size(), [&](int worker, uint64_t begin, uint64_t end) {
+            search_medium(worker, medium_combos, begin, end);
+        }, found_medium.set);
+        scheduler.add("hard", hard_combos.size(), [&](int worker, uint64_t begin, uint64_t end) {
+            search_hard(worker, hard_combos, begin, end);
+        }, found_hard.set);
+        scheduler.run(pool);
+
+        auto& lists = candidates.sorted();
+        vector<int> chosen = pack_disjoint(lists);
+        array<optional<PuzzleResult>*, NUM_DIFFICULTIES> results = {
+            &easy1_result, &easy2_result, &medium_result, &hard_result
+        };
+        const char* titles[] = {"EASY PUZZLE 1", "EASY PUZZLE 2", "MEDIUM PUZZLE", "HARD PUZZLE"};
+        for (int d = 0; d < NUM_DIFFICULTIES; d++) {
+            announce("Candidates for " + string(titles[d]) + ": " + to_string(lists[d].size()));
+            if (chosen[d] >= 0) *results[d] = lists[d][chosen[d]];
+        }
+        for (int d = 0; d < NUM_DIFFICULTIES; d++) print_result(titles[d], *results[d]);
+    };
+
+    uint64_t random_rank = UINT64_MAX;
+    if (do_random) {
+        // Double-six while it has enough dominoes, double-nine beyond that
+        vector<Domino> random_pool = all_d6;
+        if (random_dominoes > (int)all_d6.size()) {
+            random_pool.insert(random_pool.end(), d9_remainder.begin(), d9_remainder.end());
+        }
+        announce("\nSampling " + to_string(random_samples) + " random layouts (seed " +
+                 to_string(random_seed) + ", " + to_string(random_dominoes) + " dominoes)...");
+        random_slots.assign(pool.size(), RandomSlot());
+        parallel_for(pool, random_samples, [&](int worker, uint64_t begin, uint64_t end) {
+            search_random(worker, random_seed, random_pool, random_dominoes, do_refine, begin, end);
+        }, 0, "random");
+        for (auto& slot : random_slots) {
+            if (slot.sample < random_rank) {
+                random_rank = slot.sample;
+                random_result = move(slot.result);
+            }
         }
-        for (auto& t : threads) t.join();
+        if (!collector.enabled()) print_result(do_refine ? "REFINED PUZZLE" : "RANDOM PUZZLE", random_result);
+    }
+
+    if (do_daily) daily_searches();
+
+    // Checkpointed searches write their collected records out as each
+    // step is recorded done
+    collector.hold = checkpoint.enabled;
+    thread easy_driver(easy_chain);
+    thread medium_hard_driver(medium_hard_chain);
+    easy_driver.join();
+    medium_hard_driver.join();
+    collector.flush_all();
+
+    {
+        lock_guard<mutex> lock(writer_mutex);
+        searches_done = true;
+    }
+    writer_wake.notify_all();
+    if (reporter_thread.joinable()) {
+        reporter_thread.join();
+        // Leave the final counts in the metrics file
+        if (!metrics_path.empty()) reporter.report();
+    }
+    if (writer.joinable()) {
+        writer.join();
+        // Every search ran to completion, so there is nothing to resume
+        remove(checkpoint.path.c_str());
     }
 
     auto end = chrono::high_resolution_clock::now();
@@ -952,12 +6107,82 @@ int main(int argc, char* argv[]) {
     cout << "\n==================================================" << endl;
     cout << "FINAL SUMMARY (Total time: " << duration.count() << "ms)" << endl;
     cout << "Total attempts: " << total_attempts.load() << endl;
+    uint64_t rejected = 0;
+    for (const auto& r : rejections) rejected += r.load();
+    cout << "Pre-filter rejected: " << rejected
+         << " (sum range " << rejections[(int)Rejection::SUM_RANGE].load()
+         << ", pip multiset " << rejections[(int)Rejection::PIP_MULTISET].load()
+         << ", ordering " << rejections[(int)Rejection::ORDERING].load()
+         << ", total " << rejections[(int)Rejection::TOTAL].load() << ")" << endl;
+    cout << "Solver calls: " << total_attempts.load() - rejected << endl;
+    if (telemetry.enabled) {
+        cout << "Search tree: " << telemetry.nodes.load() << " nodes, "
+             << telemetry.dead_ends.load() << " dead ends; pruned";
+        for (int i = 0; i <= NUM_CONSTRAINT_TYPES; i++) {
+            cout << (i ? ", " : " ") << PRUNE_REASONS[i] << " " << telemetry.pruned[i].load();
+        }
+        cout << endl;
+        uint64_t probes = telemetry.tt_probes.load(), hits = telemetry.tt_hits.load();
+        cout << "Transposition table: " << probes << " probes, " << hits << " hits";
+        if (probes) cout << " (" << 100.0 * hits / probes << "%)";
+        cout << endl;
+    }
     cout << "==================================================" << endl;
 
+    if (shard.enabled) {
+        ShardReport report;
+        report.index = shard.index;
+        report.count = shard.count;
+        report.mode = mode;
+        report.exclude = exclude_list;
+        report.attempts = total_attempts.load();
+        report.unique = found_random.load();
+        report.collected = collector.count();
+        for (int i = 0; i < NUM_REJECTIONS; i++) report.rejected[i] = rejections[i].load();
+        report.has_telemetry = telemetry.enabled;
+        report.nodes = telemetry.nodes.load();
+        report.dead_ends = telemetry.dead_ends.load();
+        for (size_t i = 0; i < report.pruned.size(); i++) report.pruned[i] = telemetry.pruned[i].load();
+        if (do_daily) {
+            report.candidates = candidates.sorted();
+        } else {
+            auto keep = [&](const char* tag, const Found& found, const optional<PuzzleResult>& result) {
+                if (result) report.results[tag] = {found.rank.load(), *result};
+            };
+            keep("easy1", found_easy1, easy1_result);
+            keep("easy2", found_easy2, easy2_result);
+            keep("medium", found_medium, medium_result);
+            keep("hard", found_hard, hard_result);
+            if (random_result) report.results["random"] = {random_rank, *random_result};
+        }
+        if (report.save(shard_path)) {
+            cout << "Shard report: " << shard_path << endl;
+        } else {
+            cout << "Cannot write shard report " << shard_path << endl;
+            return 1;
+        }
+    }
+
+    if (collector.enabled()) {
+        cout << "Collected: " << collector.count() << " puzzles in " << collect_path << endl;
+        return 0;
+    }
     if (do_easy1) cout << "Easy1: " << (easy1_result ? "FOUND" : "NOT FOUND") << endl;
     if (do_easy2) cout << "Easy2: " << (easy2_result ? "FOUND" : "NOT FOUND") << endl;
     if (do_medium) cout << "Medium: " << (medium_result ? "FOUND" : "NOT FOUND") << endl;
     if (do_hard) cout << "Hard: " << (hard_result ? "FOUND" : "NOT FOUND") << endl;
+    if (do_daily) {
+        int packed = !!easy1_result + !!easy2_result + !!medium_result + !!hard_result;
+        cout << "Daily set: " << packed << " of " << NUM_DIFFICULTIES
+             << " difficulties with disjoint dominoes" << endl;
+    }
+    if (do_refine) {
+        cout << "Refined: " << found_random.load() << " unique of " << random_samples << " samples, "
+             << refine_solves.load() << " solves" << endl;
+    } else if (do_random) {
+        cout << "Random: " << found_random.load() << " unique of " << random_samples << endl;
+    }
 
     return 0;
 }
+#endif  // PUZZLE_GEN_NO_MAIN
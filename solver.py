@@ -9,6 +9,12 @@ from copy import deepcopy
 from domino_sets import Domino, DominoSet
 from grid import Puzzle, Region, PlacedDomino, Orientation, ConstraintType
 
+# C++ solver from pips_native.cpp, when it has been built
+try:
+    import pips_native
+except ImportError:
+    pips_native = None
+
 
 @dataclass
 class SolverState:
@@ -25,10 +31,12 @@ class Solver:
     Backtracking solver that places dominoes to satisfy region constraints.
     """
 
-    def __init__(self, puzzle: Puzzle, max_solutions: int = 2):
+    def __init__(self, puzzle: Puzzle, max_solutions: int = 2, native: bool = True):
         self.puzzle = puzzle
         self.max_solutions = max_solutions
+        self.native = native and pips_native is not None
         self.solutions: List[List[PlacedDomino]] = []
+        self.solution_count = 0
 
         # Build lookup structures
         self.cell_to_region: Dict[Tuple[int, int], int] = {}
@@ -129,6 +137,9 @@ class Solver:
         Solve the puzzle and return number of unique solutions.
         Solutions are deduplicated by which dominoes are in which regions.
         """
+        if self.native:
+            return self._solve_native()
+
         self.solutions = []
         self.seen_assignments: Set[frozenset] = set()
         initial_state = SolverState(
@@ -138,7 +149,28 @@ class Solver:
             cell_values={}
         )
         self._backtrack(initial_state)
-        return len(self.solutions)
+        self.solution_count = len(self.solutions)
+        return self.solution_count
+
+    def _solve_native(self) -> int:
+        """
+        Count solutions with the C++ solver. Only the first solution is
+        returned by it, so self.solutions holds at most one entry.
+        """
+        count, placements = pips_native.solve(self.puzzle, self.max_solutions)
+        self.solutions = []
+        if placements is not None:
+            # A supply may repeat a domino; each placement takes its own copy
+            by_pips: Dict[Tuple[int, int], List[Domino]] = {}
+            for d in reversed(self.puzzle.supply.dominoes):
+                by_pips.setdefault((d.low, d.high), []).append(d)
+            self.solutions.append([
+                PlacedDomino(by_pips[(min(a, b), max(a, b))].pop(), row, col,
+                             Orientation.HORIZONTAL if horizontal else Orientation.VERTICAL)
+                for a, b, row, col, horizontal in placements
+            ])
+        self.solution_count = count
+        return count
 
     def _get_solution_signature(self, state: SolverState) -> frozenset:
         """
@@ -263,7 +295,7 @@ class Solver:
 
     def is_unique(self) -> bool:
         """Check if puzzle has exactly one solution."""
-        return len(self.solutions) == 1
+        return self.solution_count == 1
 
 
 def verify_puzzle_uniqueness(puzzle: Puzzle) -> Tuple[bool, int]: